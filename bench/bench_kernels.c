@@ -0,0 +1,145 @@
+
+/*
+
+    Banc d'essai des noyaux double précision
+
+    Compare sur des vues riches en bord de l'ensemble les noyaux vectorisés à
+    groupes fixes et leurs variantes à remplissage continu des voies, puis les
+    variantes double-double.
+
+    Utilisation: ./bench-kernels [threads] [taille des tuiles]
+
+*/
+
+#define SDL_MAIN_HANDLED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "fractal.h"
+#include "thread_pool.h"
+#include "kernels.h"
+#include "dispatch.h"
+
+// Nombre de mesures par noyau, on garde la meilleure
+#define BENCH_RUNS 3
+
+
+typedef struct {
+    const char *name;
+    double zoom, offsetX, offsetY;
+    int max_iteration;
+} BenchView;
+
+static const BenchView views[] = {
+    { "depart",           200.0, -0.5,            0.0,           200   },
+    { "vallee-hippocampe", 2e5,  -0.7436447860,   0.1318252536,  2000  },
+    { "vallee-elephant",   3e3,   0.2817,         0.0110,        1000  },
+    { "mini-mandelbrot",   4e9,  -1.7685736562,   0.0017616114,  5000  },
+    { "spirale-profonde",  1e12, -0.743643887037151, 0.131825904205330, 10000 },
+};
+
+
+// Mesure le meilleur temps de calcul d'une image, en millisecondes
+static double time_kernel(ThreadPool *pool, FractalTask *task, SpanKernel kernel) {
+    double best = 0.0;
+
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        thread_pool_launch(pool, task, kernel);
+        thread_pool_wait(pool);
+        double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+        if (run == 0 || ms < best)
+            best = ms;
+    }
+
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    int threadCount = (argc > 1) ? atoi(argv[1]) : 0;
+    int tileSize = (argc > 2) ? atoi(argv[2]) : DEFAULT_TILE_SIZE;
+    int w = 1200, h = 800;
+
+    ThreadPool *pool = thread_pool_create(threadCount, tileSize);
+
+    int actualMax = 0, progress = 0;
+    bool finished = false;
+    FractalTask task = {0};
+    task.iterationMap = malloc(w * h * sizeof(int));
+    task.actual_max = &actualMax;
+    task.progress = &progress;
+    task.finished = &finished;
+    task.width = w;
+    task.height = h;
+
+    int *reference = malloc(w * h * sizeof(int));
+
+    printf("%dx%d, %d threads, tuiles de %d\n\n", w, h, thread_pool_thread_count(pool), tileSize);
+    printf("%-18s %-15s %10s %12s %10s\n", "vue", "noyau", "temps (ms)", "Gitér/s", "identique");
+
+    for (size_t v = 0; v < sizeof(views) / sizeof(views[0]); v++) {
+        task.zoom = views[v].zoom;
+        task.pixelSize = fe_from_double(1.0 / views[v].zoom);
+        task.offsetX = views[v].offsetX;
+        task.offsetY = views[v].offsetY;
+        task.max_iteration = views[v].max_iteration;
+
+        // Le noyau scalaire, en dernier dans le tableau, sert de référence pour la vérification
+        time_kernel(pool, &task, calculate_iterations);
+        memcpy(reference, task.iterationMap, w * h * sizeof(int));
+
+        for (int k = 0; k < double_kernel_variant_count; k++) {
+            const KernelVariant *variant = &double_kernel_variants[k];
+            if (!kernel_variant_supported(variant))
+                continue;
+
+            double ms = time_kernel(pool, &task, variant->kernel);
+
+            int64_t iterations = 0;
+            bool identical = true;
+            for (int i = 0; i < w * h; i++) {
+                iterations += task.iterationMap[i];
+                if (reference[i] != task.iterationMap[i])
+                    identical = false;
+            }
+
+            printf("%-18s %-15s %10.1f %12.3f %10s\n", views[v].name, variant->name, ms,
+                   iterations / (ms * 1e6), identical ? "oui" : "NON");
+        }
+
+        // Noyaux double-double, comparés à leur propre version scalaire
+        time_kernel(pool, &task, calculate_iterations_double_double);
+        memcpy(reference, task.iterationMap, w * h * sizeof(int));
+
+        for (int k = 0; k < double_double_kernel_variant_count; k++) {
+            const KernelVariant *variant = &double_double_kernel_variants[k];
+            if (!kernel_variant_supported(variant))
+                continue;
+
+            double ms = time_kernel(pool, &task, variant->kernel);
+
+            int64_t iterations = 0;
+            bool identical = true;
+            for (int i = 0; i < w * h; i++) {
+                iterations += task.iterationMap[i];
+                if (reference[i] != task.iterationMap[i])
+                    identical = false;
+            }
+
+            printf("%-18s %-15s %10.1f %12.3f %10s\n", views[v].name, variant->name, ms,
+                   iterations / (ms * 1e6), identical ? "oui" : "NON");
+        }
+        printf("\n");
+    }
+
+    thread_pool_destroy(pool);
+    free(reference);
+    free(task.iterationMap);
+
+    return 0;
+}
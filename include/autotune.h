@@ -0,0 +1,34 @@
+
+/*
+
+    Réglage automatique du noyau, de la taille des tuiles et du nombre de threads
+
+*/
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include "fractal.h"
+
+// Fichier local où est gardé le réglage de la machine
+#define TUNE_CONFIG_PATH "fractal-tune.cfg"
+
+
+typedef struct {
+    char kernel[32];
+    int tileSize;
+    int threadCount;
+} TuneConfig;
+
+
+// Réglage sans mesure: meilleur noyau supporté, tuiles par défaut, tous les coeurs
+void default_tune_config(TuneConfig *config);
+
+// Faux si le fichier n'existe pas, est invalide ou vient d'un autre processeur
+bool load_tune_config(const char *path, TuneConfig *config);
+bool save_tune_config(const char *path, const TuneConfig *config);
+
+// Mesure rapidement les combinaisons et garde la plus rapide
+void autotune(TuneConfig *config);
+
+#endif
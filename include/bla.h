@@ -0,0 +1,107 @@
+
+/*
+
+    Approximations bilinéaires (BLA) de l'orbite de référence
+
+    Tant que l'écart d d'un pixel reste petit devant Z_m, plusieurs itérations de
+    perturbation à partir de l'itération m se résument à d -> A d + B dc, avec A et B communs
+    à tous les pixels. La table garde ces approximations pour des blocs de 1, 2,
+    4... itérations, chacune avec le rayon de d en dessous duquel elle est juste.
+
+    Au-delà des zooms que le double permet, la table est construite en floatexp.
+
+*/
+
+#ifndef BLA_H
+#define BLA_H
+
+#include "fractal.h"
+#include "floatexp.h"
+
+// Seulement pour la version linux
+#ifdef __linux__
+
+    struct ReferenceOrbit;
+
+    // d -> A d + B dc, valable si |d| < radius (complexes en (réel, imaginaire))
+    typedef struct {
+        double A[2];
+        double B[2];
+        double radius;
+    } BlaStep;
+
+    // Même bloc à exposant étendu
+    typedef struct {
+        floatexp A[2];
+        floatexp B[2];
+        floatexp radius;
+    } BlaStepExp;
+
+    // Le niveau l contient les blocs de 2^l itérations commençant en m = 1 + j 2^l
+    typedef struct {
+        BlaStep *steps;         // Tous les niveaux à la suite, NULL si la table est étendue
+        BlaStepExp *stepsExp;   // Idem en floatexp, NULL sinon
+        bool extended;
+        int levelOffset[32];
+        int levelCount[32];
+        int levels;
+
+        floatexp dcMax;         // Plus grand |dc| de l'image pour lequel les rayons ont été calculés
+    } BlaTable;
+
+    // (Re)construit la table sur l'orbite de référence, en parallèle sur threadCount threads
+    // Elle est étendue si dcMax est trop petit pour le double
+    void bla_table_build(BlaTable *table, const struct ReferenceOrbit *orbit, floatexp dcMax, int threadCount);
+
+    void bla_table_free(BlaTable *table);
+
+    // Plus haut niveau utilisable en m, -1 si aucun: les blocs doivent commencer en m et tenir en maxSteps itérations
+    static inline int bla_top_level(const BlaTable *table, int m, int maxSteps) {
+        if (m < 1 || table->levels == 0)
+            return -1;
+
+        int t = m - 1;
+        int top = (t == 0) ? table->levels - 1 : __builtin_ctz(t);
+        if (top > table->levels - 1)
+            top = table->levels - 1;
+        while (top >= 0 && ((1 << top) > maxSteps || (t >> top) >= table->levelCount[top]))
+            top--;
+        return top;
+    }
+
+    // Plus long bloc valable en m pour un écart de norme² dNormSqr, d'au plus maxSteps itérations
+    // Retourne NULL si aucun, sinon *steps reçoit le nombre d'itérations sautées
+    // Le rayon d'un bloc ne dépasse jamais celui de sa première moitié: on monte tant que ça passe
+    static inline const BlaStep *bla_lookup(const BlaTable *table, int m, double dNormSqr, int maxSteps, int *steps) {
+        int top = bla_top_level(table, m, maxSteps);
+
+        const BlaStep *found = 0;
+        for (int level = 0; level <= top; level++) {
+            const BlaStep *step = &table->steps[table->levelOffset[level] + ((m - 1) >> level)];
+            if (!(dNormSqr < step->radius * step->radius))
+                break;
+
+            found = step;
+            *steps = 1 << level;
+        }
+        return found;
+    }
+
+    static inline const BlaStepExp *bla_lookup_exp(const BlaTable *table, int m, floatexp dNormSqr, int maxSteps, int *steps) {
+        int top = bla_top_level(table, m, maxSteps);
+
+        const BlaStepExp *found = 0;
+        for (int level = 0; level <= top; level++) {
+            const BlaStepExp *step = &table->stepsExp[table->levelOffset[level] + ((m - 1) >> level)];
+            if (!fe_less(dNormSqr, fe_mul(step->radius, step->radius)))
+                break;
+
+            found = step;
+            *steps = 1 << level;
+        }
+        return found;
+    }
+
+#endif
+
+#endif
@@ -0,0 +1,51 @@
+
+/*
+
+    Choix à l'exécution du noyau adapté au processeur
+
+*/
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include <stddef.h>
+
+#include <SDL2/SDL.h>
+
+#include "fractal.h"
+#include "thread_pool.h"
+
+
+// Une variante compilée d'un noyau et le test CPUID des instructions dont elle a besoin
+typedef struct {
+    const char *name;
+    SpanKernel kernel;
+    SDL_bool (*supported)(void);  // NULL si toujours disponible
+    bool resumable;               // Sait reprendre les pixels arrêtés au maximum d'un calcul précédent (task->resumeFrom)
+} KernelVariant;
+
+// Variantes double précision, de la plus rapide à la plus lente à largeur égale
+extern const KernelVariant double_kernel_variants[];
+extern const int double_kernel_variant_count;
+
+bool kernel_variant_supported(const KernelVariant *variant);
+
+// Variante par son nom, NULL si inconnue ou non supportée par ce processeur
+const KernelVariant *find_double_kernel(const char *name);
+
+// Première variante supportée, dans l'ordre de préférence du tableau
+const KernelVariant *best_double_kernel(void);
+
+// La variante elle-même si elle sait reprendre un calcul, sinon la première variante supportée qui le sait
+const KernelVariant *resumable_double_kernel(const KernelVariant *variant);
+
+// Variantes double-double, même ordre de préférence
+extern const KernelVariant double_double_kernel_variants[];
+extern const int double_double_kernel_variant_count;
+
+const KernelVariant *best_double_double_kernel(void);
+
+// Identifie le processeur (modèle, coeurs, instructions), pour invalider un réglage fait sur une autre machine
+void cpu_signature(char *buffer, size_t size);
+
+#endif
@@ -0,0 +1,100 @@
+
+/*
+
+    Arithmétique double-double
+
+    Un nombre est la somme non évaluée de deux doubles, hi + lo avec |lo| <= ulp(hi) / 2,
+    soit environ 106 bits de mantisse. Les opérations reposent sur les transformations
+    exactes two_sum et two_prod, qui donnent l'erreur d'arrondi d'une addition ou d'un
+    produit sous forme d'un second double.
+
+    Ici two_prod coupe les facteurs en deux moitiés de 26 bits (Dekker) pour ne pas
+    dépendre du FMA; les noyaux vectorisés utilisent le FMA, le résultat est le même
+    puisque les deux donnent l'erreur exacte.
+
+*/
+
+#ifndef DOUBLE_DOUBLE_H
+#define DOUBLE_DOUBLE_H
+
+typedef struct {
+    double hi, lo;
+} doubledouble;
+
+
+static inline doubledouble dd_make(double hi, double lo) {
+    doubledouble r = { hi, lo };
+    return r;
+}
+
+// a + b = s + e exactement
+static inline double two_sum(double a, double b, double *e) {
+    double s = a + b;
+    double bb = s - a;
+    *e = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+// Idem si |a| >= |b|
+static inline double quick_two_sum(double a, double b, double *e) {
+    double s = a + b;
+    *e = b - (s - a);
+    return s;
+}
+
+// a * b = p + e exactement
+static inline double two_prod(double a, double b, double *e) {
+    const double split = 134217729.0;   // 2^27 + 1
+
+    double t = split * a;
+    double ahi = t - (t - a);
+    double alo = a - ahi;
+    t = split * b;
+    double bhi = t - (t - b);
+    double blo = b - bhi;
+
+    double p = a * b;
+    *e = ((ahi * bhi - p) + ahi * blo + alo * bhi) + alo * blo;
+    return p;
+}
+
+// Addition juste même quand a et b s'annulent presque (x² - y²)
+static inline doubledouble dd_add(doubledouble a, doubledouble b) {
+    double e, f;
+    double s = two_sum(a.hi, b.hi, &e);
+    double t = two_sum(a.lo, b.lo, &f);
+    e += t;
+    s = quick_two_sum(s, e, &e);
+    e += f;
+    s = quick_two_sum(s, e, &e);
+    return dd_make(s, e);
+}
+
+static inline doubledouble dd_sub(doubledouble a, doubledouble b) {
+    return dd_add(a, dd_make(-b.hi, -b.lo));
+}
+
+static inline doubledouble dd_mul(doubledouble a, doubledouble b) {
+    double e;
+    double p = two_prod(a.hi, b.hi, &e);
+    e += a.hi * b.lo + a.lo * b.hi;
+    p = quick_two_sum(p, e, &e);
+    return dd_make(p, e);
+}
+
+static inline doubledouble dd_sqr(doubledouble a) {
+    double e;
+    double p = two_prod(a.hi, a.hi, &e);
+    e += 2.0 * a.hi * a.lo;
+    p = quick_two_sum(p, e, &e);
+    return dd_make(p, e);
+}
+
+// Produit exact de deux doubles
+static inline doubledouble dd_prod_d(double a, double b) {
+    double e;
+    double p = two_prod(a, b, &e);
+    return dd_make(p, e);
+}
+
+#endif
@@ -0,0 +1,168 @@
+
+/*
+
+    Nombres à exposant étendu (floatexp)
+
+    Une mantisse double normalisée dans [1, 2[ (ou 0) et un exposant entier à
+    part: x = mantisse * 2^exposant. La précision reste celle d'un double, mais
+    l'exposant n'est plus limité à ±1023. Les écarts entre pixels au-delà d'un
+    zoom de 1e308 restent ainsi calculés avec les flottants du processeur.
+
+*/
+
+#ifndef FLOATEXP_H
+#define FLOATEXP_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+
+// Seulement pour la version linux
+#ifdef __linux__
+    #include <mpfr.h>
+#endif
+
+// Exposant de zéro, assez petit pour qu'il disparaisse dans toute addition
+#define FLOATEXP_ZERO_EXP (INT32_MIN / 4)
+
+// En dessous de 2^-960 (environ 1e-289), les écarts en double perdent de la précision puis s'annulent
+#define FLOATEXP_DOUBLE_MIN_EXP -960
+
+typedef struct {
+    double mantissa;
+    int32_t exponent;
+} floatexp;
+
+
+// Remet m * 2^e sous forme normalisée
+static inline floatexp fe_normalize(double m, int64_t e) {
+    floatexp r;
+    if (m == 0.0) {
+        r.mantissa = 0.0;
+        r.exponent = FLOATEXP_ZERO_EXP;
+        return r;
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &m, sizeof(bits));
+    int biased = (int)((bits >> 52) & 0x7ff);
+
+    // Dénormalisé: frexp s'en charge, cas rare
+    if (biased == 0) {
+        int k;
+        m = frexp(m, &k) * 2.0;
+        r.mantissa = m;
+        r.exponent = (int32_t)(e + k - 1);
+        return r;
+    }
+
+    bits = (bits & ~(0x7ffULL << 52)) | (1023ULL << 52);
+    memcpy(&r.mantissa, &bits, sizeof(bits));
+    r.exponent = (int32_t)(e + biased - 1023);
+    return r;
+}
+
+static inline floatexp fe_from_double(double x) {
+    return fe_normalize(x, 0);
+}
+
+// Arrondi en double, 0 ou infini hors de portée
+static inline double fe_to_double(floatexp x) {
+    if (x.exponent < -1100)
+        return 0.0 * x.mantissa;
+    if (x.exponent > 1100)
+        return x.mantissa * INFINITY;
+    return ldexp(x.mantissa, x.exponent);
+}
+
+// 2^k pour -1022 <= k <= 1023, sans passer par ldexp
+static inline double fe_pow2(int k) {
+    uint64_t bits = (uint64_t)(k + 1023) << 52;
+    double r;
+    memcpy(&r, &bits, sizeof(r));
+    return r;
+}
+
+static inline floatexp fe_mul(floatexp a, floatexp b) {
+    return fe_normalize(a.mantissa * b.mantissa, (int64_t)a.exponent + b.exponent);
+}
+
+static inline floatexp fe_mul_d(floatexp a, double b) {
+    return fe_normalize(a.mantissa * b, a.exponent);
+}
+
+static inline floatexp fe_div(floatexp a, floatexp b) {
+    return fe_normalize(a.mantissa / b.mantissa, (int64_t)a.exponent - b.exponent);
+}
+
+static inline floatexp fe_add(floatexp a, floatexp b) {
+    if (a.exponent < b.exponent) {
+        floatexp t = a;
+        a = b;
+        b = t;
+    }
+
+    // Au-delà de 64 bits d'écart, b ne change plus a
+    int shift = b.exponent - a.exponent;
+    if (shift < -64)
+        return a;
+
+    return fe_normalize(a.mantissa + b.mantissa * fe_pow2(shift), a.exponent);
+}
+
+static inline floatexp fe_neg(floatexp a) {
+    a.mantissa = -a.mantissa;
+    return a;
+}
+
+static inline floatexp fe_sub(floatexp a, floatexp b) {
+    return fe_add(a, fe_neg(b));
+}
+
+// Multiplie par 2^k, exact
+static inline floatexp fe_ldexp(floatexp a, int k) {
+    if (a.mantissa != 0.0)
+        a.exponent += k;
+    return a;
+}
+
+static inline floatexp fe_sqrt(floatexp a) {
+    // Exposant pair pour qu'il se divise par deux
+    if (a.exponent & 1)
+        return fe_normalize(sqrt(a.mantissa * 2.0), (a.exponent - 1) / 2);
+    return fe_normalize(sqrt(a.mantissa), a.exponent / 2);
+}
+
+// a < b pour a et b positifs ou nuls
+static inline int fe_less(floatexp a, floatexp b) {
+    return a.exponent < b.exponent || (a.exponent == b.exponent && a.mantissa < b.mantissa);
+}
+
+// Arrondi d'un nombre MPFR, sans limite d'exposant
+#ifdef __linux__
+    static inline floatexp fe_from_mpfr(mpfr_srcptr x) {
+        long exponent;
+        double mantissa = mpfr_get_d_2exp(&exponent, x, MPFR_RNDN);
+        return fe_normalize(mantissa, exponent);
+    }
+#endif
+
+// Ecrit x en notation scientifique décimale, quel que soit son exposant
+static inline void fe_format(char *buffer, size_t size, floatexp x) {
+    if (x.mantissa == 0.0) {
+        snprintf(buffer, size, "0");
+        return;
+    }
+
+    double l = log10(fabs(x.mantissa)) + x.exponent * 0.30102999566398119521;
+    double e = floor(l);
+    double m = pow(10.0, l - e);
+    if (m >= 9.9999995) {
+        m /= 10.0;
+        e += 1.0;
+    }
+    snprintf(buffer, size, "%s%.6fe%+.0f", x.mantissa < 0.0 ? "-" : "", m, e);
+}
+
+#endif
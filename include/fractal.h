@@ -0,0 +1,80 @@
+
+/*
+
+    Définitions communes au programme et aux moteurs de calcul du Mandelbrot
+
+*/
+
+#ifndef FRACTAL_H
+#define FRACTAL_H
+
+#include <stdint.h>
+
+#include "floatexp.h"
+
+// Seulement pour la version linux
+#ifdef __linux__
+    #include <mpfr.h>
+#endif
+
+// Etats vrais ou faux
+#define false 0
+#define true 1
+
+// Type des booléens
+#define bool uint8_t
+
+// Retourne la valeur la plus petite ou la plus grande des deux
+#define smallest(a, b) ((a > b) ? (b) : (a))
+#define largest(a, b)  ((a < b) ? (b) : (a))
+
+
+// Manière de parcourir une tuile de l'image
+typedef enum {
+    RENDER_PIXELS,      // Tous les pixels sont itérés
+    RENDER_SUBDIVIDE,   // Mariani-Silver: seuls les bords des rectangles sont itérés, les rectangles uniformes sont remplis
+    RENDER_TRACE,       // Suivi des frontières entre nombres d'itérations dans chaque tuile, tuiles en parallèle
+    RENDER_TRACE_FRAME, // Suivi des frontières sur toute l'image d'un seul tenant, par un seul worker
+    RENDER_MODE_COUNT
+} RenderMode;
+
+// Définie dans perturbation.h
+struct ReferenceOrbit;
+
+
+// Décrit une image à calculer, partagée entre le thread principal et les threads de calcul
+typedef struct {
+    int *iterationMap;
+    int max_iteration;
+    int *actual_max;
+    double zoom, offsetX, offsetY;     // zoom arrondi en double, plafonné à DBL_MAX
+    floatexp pixelSize;                // 1 / zoom sans limite d'exposant, pour les noyaux des zooms profonds
+    double offsetXLow, offsetYLow;     // Reste du centre sous offsetX et offsetY, pour le double-double
+    #ifdef __linux__
+        mpfr_t centerX, centerY;       // Centre exact de la vue, offsetX et offsetY en sont les arrondis
+    #endif
+    int width, height;
+    bool antialiasing;
+    RenderMode renderMode;
+    bool verifyFills;   // Itère quand même les pixels remplis et compte ceux qui auraient été faux
+    struct ReferenceOrbit *reference;  // Orbite de référence pour le calcul par perturbation
+    bool nucleusReference;             // Prend comme référence le noyau de plus petite période de l'image plutôt que le centre
+    bool seriesApproximation;          // Démarre les pixels perturbés après les itérations prévues par une série
+    bool bilinearApproximation;        // Construit la table BLA de l'orbite de référence
+    bool pipelinedReference;           // Les pixels perturbés suivent l'orbite de référence pendant son calcul
+
+    // Etat z de chaque pixel arrêté au maximum, pour reprendre le calcul quand seul max_iteration augmente
+    // NaN si le pixel ne s'échappera jamais, (0, 0) s'il n'y a pas d'état (pixel rempli), NULL s'il n'est pas gardé
+    double *resumeX, *resumeY;
+    int resumeFrom;     // max_iteration du calcul qui a laissé iterationMap et l'état, 0 pour partir de zéro
+
+    int *progress;  // De 0 à 100
+    bool *finished;
+
+    // Statistiques du calcul, chaque pointeur peut être NULL
+    int64_t *iterationsSaved;  // Itérations évitées par la détection de périodicité
+    int64_t *pixelsComputed;   // Pixels réellement itérés
+    int64_t *fillErrors;       // Pixels remplis à tort, seulement si verifyFills
+} FractalTask;
+
+#endif
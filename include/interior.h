@@ -0,0 +1,44 @@
+
+/*
+
+    Détection des points à l'intérieur des deux plus grandes composantes de l'ensemble
+
+*/
+
+#ifndef INTERIOR_H
+#define INTERIOR_H
+
+#include "fractal.h"
+
+
+// Vrai si le point est dans la cardioïde principale ou dans le disque de période 2
+// L'orbite de ces points ne s'échappe jamais, on peut leur donner directement max_iteration
+static inline bool in_main_cardioid_or_bulb(double x, double y) {
+    double ysqr = y * y;
+
+    // Cardioïde: q(q + (x - 1/4)) <= y²/4 avec q = (x - 1/4)² + y²
+    double xq = x - 0.25;
+    double q = xq * xq + ysqr;
+    if (q * (q + xq) <= 0.25 * ysqr)
+        return true;
+
+    // Disque de centre -1 et de rayon 1/4
+    double xb = x + 1.0;
+    return xb * xb + ysqr <= 0.0625;
+}
+
+
+// Détection de périodicité (Brent): l'orbite est comparée à un point gardé, remplacé à chaque puissance
+// de 2 d'itérations. Si elle y revient à la précision près, elle est prise dans un cycle attractif.
+// Marge en bits sous la précision du calcul pour considérer deux points de l'orbite comme confondus
+#define PERIODICITY_GUARD_BITS 12
+
+// Tolérance en double précision: 2^-(53 - PERIODICITY_GUARD_BITS)
+#define PERIODICITY_TOLERANCE (1.0 / (double)(1LL << (53 - PERIODICITY_GUARD_BITS)))
+
+// Vrai si l'itération n est une puissance de 2, où le point de comparaison est remplacé
+static inline bool periodicity_checkpoint(int n) {
+    return (n & (n - 1)) == 0;
+}
+
+#endif
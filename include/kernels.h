@@ -0,0 +1,105 @@
+
+/*
+
+    Noyaux de calcul des itérations du Mandelbrot
+
+*/
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <math.h>
+
+#include "fractal.h"
+#include "thread_pool.h"
+
+// Calcul en double précision d'une portion de ligne, exécuté par le pool de threads
+// Garde l'état des pixels arrêtés au maximum si task->resumeX, et reprend ceux du calcul précédent si task->resumeFrom
+void calculate_iterations(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+
+// Variantes vectorisées, identiques bit à bit au noyau scalaire
+// Toutes gardent l'état des pixels, seules celles marquées resumable dans dispatch.c savent reprendre
+#if defined(__x86_64__) || defined(__i386__)
+    void calculate_iterations_sse2(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+    void calculate_iterations_avx2(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+    void calculate_iterations_avx512(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+
+    // Variantes qui remplacent le pixel d'une voie dès qu'il a fini
+    void calculate_iterations_stream_avx2(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+    void calculate_iterations_stream_avx512(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+#endif
+
+// Point de départ d'un pixel d'un calcul qui reprend le précédent (task->resumeFrom > 0)
+// Faux si le pixel garde son résultat: échappé avant l'ancien maximum, ou au maximum pour toujours (mis à jour)
+// Il n'est alors pas compté comme calculé
+// Sinon (x, y) et *iteration reçoivent l'état gardé, ou (0, 0) et 0 si le pixel n'en a pas
+static inline bool resume_pixel(const FractalTask *task, WorkerContext *ctx, int index, double *x, double *y, int *iteration) {
+    int *result = task->iterationMap + index;
+    if (*result != task->resumeFrom || isnan(task->resumeX[index])) {
+        // Au maximum pour toujours: il y reste avec le nouveau maximum
+        if (*result == task->resumeFrom)
+            *result = task->max_iteration;
+        ctx->pixelsComputed--;
+        return false;
+    }
+
+    *x = task->resumeX[index];
+    *y = task->resumeY[index];
+    *iteration = (*x != 0.0 || *y != 0.0) ? task->resumeFrom : 0;
+    return true;
+}
+
+// Bits de mantisse pour que deux pixels voisins aient des coordonnées distinctes:
+// de la plus grande valeur manipulée (|z| jusqu'à 2, le coin de l'image) à la taille d'un pixel
+int pixel_precision_bits(const FractalTask *task);
+
+// Paliers du calcul direct, du moins cher au plus cher
+typedef enum {
+    TIER_DOUBLE,
+    TIER_DOUBLE_DOUBLE,
+    TIER_HIGH           // Virgule fixe ou MPFR, seulement dans la version linux
+} PrecisionTier;
+
+// Un palier n'est gardé que si ses coordonnées de pixels voisins sont espacées d'un pixel à 2^-PRECISION_TIER_GUARD_BITS près
+#define PRECISION_TIER_GUARD_BITS 10
+
+// Palier le moins cher dont la mantisse suffit pour le zoom et la taille de l'image de la tâche:
+// pixel_precision_bits écarte les paliers trop courts, puis les coordonnées des pixels sont calculées
+// comme dans leurs noyaux pour vérifier qu'aucun voisin ne se confond
+PrecisionTier cheapest_precision_tier(const FractalTask *task);
+
+// Calcul en double-double (environ 106 bits), pour les zooms entre 1e13 et 1e28
+void calculate_iterations_double_double(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+
+// Vrai si les coordonnées double-double de deux pixels voisins de la tâche, sur toute la largeur et toute la hauteur,
+// sont espacées d'un pixel à 2^-PRECISION_TIER_GUARD_BITS près
+bool double_double_pixels_distinct(const FractalTask *task);
+
+#if defined(__x86_64__) || defined(__i386__)
+    void calculate_iterations_double_double_avx2(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+    void calculate_iterations_double_double_avx512(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+#endif
+
+// Calcul en haute précision, réparti sur le pool de threads
+// Seulement pour la version linux
+#ifdef __linux__
+    // Bits des nombres MPFR en plus de ceux qui séparent deux pixels, pour les erreurs d'arrondi accumulées
+    #define HIGH_PRECISION_GUARD_BITS 48
+
+    // Précision MPFR suffisante pour la tâche, d'après la taille d'un pixel et l'étendue de l'image
+    mpfr_prec_t high_precision_bits(const FractalTask *task);
+
+    // Noyau en virgule fixe sur 2, 3, 4, 6 ou 8 limbs de 64 bits, assez pour high_precision_bits(task)
+    // NULL (et 0 limbs) si la précision demandée dépasse 8 limbs: il faut alors passer par MPFR
+    SpanKernel fixed_point_kernel(const FractalTask *task);
+    int fixed_point_limbs(const FractalTask *task);
+
+    // Calcul d'une portion de ligne en haute précision, avec les variables de travail de ctx->scratch
+    void calculate_iterations_high_precision_span(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+
+    // Variables de travail MPFR d'un worker, créées une fois par calcul: à donner à thread_pool_launch_scratch avec le noyau précédent
+    void high_precision_scratch_create(const FractalTask *task, WorkerContext *ctx);
+    void high_precision_scratch_destroy(const FractalTask *task, WorkerContext *ctx);
+#endif
+
+#endif
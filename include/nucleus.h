@@ -0,0 +1,89 @@
+/*
+
+    Recherche de noyaux pour les zooms profonds
+
+    Le noyau d'une composante de période p est le point c où l'orbite de 0
+    revient exactement en 0 après p itérations. Son orbite ne s'échappe
+    jamais et se répète: c'est la meilleure orbite de référence pour la
+    perturbation, et un bon point où zoomer.
+
+*/
+
+#ifndef NUCLEUS_H
+#define NUCLEUS_H
+
+#include <SDL2/SDL.h>
+
+// Seulement pour la version linux
+#ifdef __linux__
+    #include <mpfr.h>
+#endif
+
+#include "fractal.h"
+#include "floatexp.h"
+
+// Seulement pour la version linux
+#ifdef __linux__
+
+    // Bits sous la taille d'un pixel où Newton s'arrête
+    #define NUCLEUS_NEWTON_BITS 32
+
+    // Nombre de pas de Newton au plus
+    #define NUCLEUS_NEWTON_STEPS 64
+
+    // Distance au centre de la vue, en rayons de l'image, où un noyau est encore accepté
+    // La boule de la détection de période déborde de l'image, le noyau trouvé peut en être un peu sorti
+    #define NUCLEUS_MAX_DISTANCE 8.0
+
+    // Plus petite période d'un noyau dans le disque de centre (cx, cy) et de rayon radius
+    // 0 si aucune jusqu'à maxPeriod, ou si tout le disque s'échappe avant
+    int nucleus_period(mpfr_srcptr cx, mpfr_srcptr cy, floatexp radius, int maxPeriod);
+
+    // Affine (x, y) par la méthode de Newton jusqu'au noyau de période period, à tolerance près
+    // Retourne false si Newton ne converge pas ou s'éloigne de plus de maxDistance du départ
+    bool nucleus_newton(mpfr_ptr x, mpfr_ptr y, int period, floatexp tolerance, floatexp maxDistance);
+
+    // Noyau de plus petite période près de l'image de task, jusqu'à max_iteration
+    // (x, y) reçoivent le noyau et *period sa période, false (et x, y inchangés) si aucun n'est trouvé
+    bool nucleus_find(const FractalTask *task, mpfr_ptr x, mpfr_ptr y, int *period);
+
+    // Résultat de la dernière recherche de noyau, gardé d'une image à l'autre
+    typedef struct {
+        bool valid;
+        mpfr_t centerX, centerY;    // Disque cherché
+        floatexp radius;
+        int maxPeriod;              // Périodes cherchées jusqu'à maxPeriod
+        int period;                 // 0 si aucun noyau n'a été trouvé
+        mpfr_t x, y;                // Noyau trouvé, à tolerance près
+        floatexp tolerance;
+        int hits;                   // Recherches évitées depuis le lancement
+    } NucleusSearch;
+
+    // Une recherche initialisée doit être libérée
+    void nucleus_search_init(NucleusSearch *search);
+    void nucleus_search_free(NucleusSearch *search);
+
+    // nucleus_find qui reprend la dernière recherche tant que le disque de l'image reste dans le disque cherché
+    // et que max_iteration ne dépasse pas les périodes cherchées: la plus petite période ne peut pas y être plus petite
+    // Un noyau repris doit encore être près de l'image, il est seulement affiné par Newton si les pixels ont rapetissé
+    bool nucleus_find_cached(const FractalTask *task, NucleusSearch *search, mpfr_ptr x, mpfr_ptr y, int *period);
+
+    // Recherche de noyau faite dans son propre thread, sur sa propre copie de la vue
+    typedef struct {
+        FractalTask task;   // Seuls le centre, pixelSize, width, height et max_iteration servent
+        mpfr_t x, y;        // Noyau trouvé
+        int period;
+        bool found;
+        SDL_atomic_t done;  // Passe à 1 à la fin de la recherche
+    } NucleusJob;
+
+    // Une recherche initialisée doit être libérée
+    void nucleus_job_init(NucleusJob *job);
+    void nucleus_job_free(NucleusJob *job);
+
+    // nucleus_find sur job->task, à lancer dans son propre thread après avoir remis job->done à 0
+    int nucleus_job_run(void *arg);
+
+#endif
+
+#endif
@@ -0,0 +1,52 @@
+/*
+
+    Orbites de référence gardées sur le disque d'une session à l'autre
+
+    Chaque orbite longue à calculer est écrite dans son propre fichier binaire
+    versionné, avec son point, sa précision et son nombre d'itérations. Au
+    lancement suivant, le fichier est projeté en mémoire (mmap) au lieu de
+    refaire le calcul MPFR.
+
+*/
+
+#ifndef ORBIT_STORE_H
+#define ORBIT_STORE_H
+
+// Seulement pour la version linux
+#ifdef __linux__
+    #include <mpfr.h>
+#endif
+
+#include "floatexp.h"
+#include "perturbation.h"
+
+// Seulement pour la version linux
+#ifdef __linux__
+
+    // Dossier local des orbites, comme le fichier de réglage
+    #define ORBIT_STORE_PATH "fractal-orbits"
+
+    // A changer avec le format des fichiers: les anciens sont ignorés puis retirés par la limite de taille
+    #define ORBIT_STORE_VERSION 1
+
+    // Taille totale des fichiers au plus, les moins récemment utilisés sont supprimés au-delà
+    #define ORBIT_STORE_MAX_BYTES ((int64_t)4 << 30)
+
+    // Une orbite calculée plus vite que ça n'est pas écrite, la relire ne ferait rien gagner
+    #define ORBIT_STORE_MIN_MS 500.0
+
+    // Un fichier temporaire plus vieux que ça a été laissé par une écriture interrompue (secondes)
+    #define ORBIT_STORE_STALE_SECONDS 60
+
+    // Charge dans orbit une orbite du dossier de période period, d'au moins minPrecision bits,
+    // dont le point est à moins de maxDistance de (x, y), et la marque comme la plus récemment utilisée
+    // Faux si aucune ne convient; les fichiers abimés rencontrés sont supprimés
+    bool orbit_store_load(const char *path, ReferenceOrbit *orbit, mpfr_srcptr x, mpfr_srcptr y, int period,
+                          mpfr_prec_t minPrecision, floatexp maxDistance);
+
+    // Ecrit l'orbite dans le dossier, à la place d'un fichier du même point, puis applique la limite de taille
+    bool orbit_store_save(const char *path, const ReferenceOrbit *orbit);
+
+#endif
+
+#endif
@@ -0,0 +1,167 @@
+
+/*
+
+    Calcul par perturbation pour les zooms profonds
+
+    Une seule orbite, celle du centre de la vue ou d'un noyau proche, est
+    calculée en haute précision. Chaque pixel n'itère ensuite que son écart à
+    cette orbite de référence, assez petit pour tenir en double précision.
+    Sur un noyau, seule la première période de l'orbite est gardée.
+
+    L'orbite est gardée d'une image à l'autre tant que son point et sa
+    précision conviennent, prolongée si le nombre d'itérations augmente. Les
+    orbites précédentes restent dans un petit cache pour revenir en arrière, et
+    celles longues à calculer sur le disque pour les sessions suivantes.
+
+*/
+
+#ifndef PERTURBATION_H
+#define PERTURBATION_H
+
+#include <SDL2/SDL.h>
+
+// Seulement pour la version linux
+#ifdef __linux__
+    #include <mpfr.h>
+#endif
+
+#include "fractal.h"
+#include "thread_pool.h"
+#include "bla.h"
+#include "nucleus.h"
+
+// Seulement pour la version linux
+#ifdef __linux__
+
+    // Valeur d'un pixel perturbé faux (glitch), en attente d'une autre référence
+    #define PERTURBATION_GLITCH -1
+
+    // Glitch quand |Z + d|² < tolérance |Z|²: l'écart d, plus grand que le point lui-même, n'a plus de chiffres justes
+    #define PERTURBATION_GLITCH_TOLERANCE 1e-6
+
+    // Références secondaires au plus par image, les glitchs restants sont calculés en haute précision
+    #define PERTURBATION_MAX_REFERENCES 64
+
+    // Orbites gardées au plus dans le cache, et mémoire totale de leurs points
+    #define ORBIT_CACHE_SIZE 8
+    #define ORBIT_CACHE_MAX_BYTES ((size_t)1 << 30)
+
+    // Bits de précision en plus de ceux demandés pour une nouvelle orbite: en zoomant, elle
+    // reste assez précise sur environ 19 décades avant de devoir être recalculée
+    #define ORBIT_PRECISION_HEADROOM 64
+
+    // Une orbite est réutilisée si son point C est à moins de 2^-ORBIT_CACHE_MATCH_BITS pixel de celui voulu
+    #define ORBIT_CACHE_MATCH_BITS 32
+
+    // Points calculés entre deux publications aux pixels qui suivent l'orbite, puissance de 2
+    #define ORBIT_PUBLISH_STEP 64
+
+    // Un pixel qui attend l'orbite vérifie au moins à cet intervalle si le pool a abandonné le calcul (ms)
+    #define ORBIT_WAIT_TIMEOUT_MS 10
+
+    // Orbite mise de côté, mêmes champs que dans ReferenceOrbit
+    typedef struct {
+        double *zr, *zi;
+        int length, capacity;
+        mpfr_t referenceX, referenceY;
+        mpfr_t lastX, lastY;
+        mpfr_prec_t precision;
+        int maxIteration;
+        int period;
+        uint64_t lastUse;   // Pour retirer la moins récemment utilisée
+    } CachedOrbit;
+
+    typedef struct {
+        CachedOrbit entries[ORBIT_CACHE_SIZE];
+        uint64_t clock;
+        int hits;           // Orbites reprises du cache depuis le lancement
+    } OrbitCache;
+
+    // Orbite de référence Z_0 = 0, Z_n+1 = Z_n² + C arrondie en double, C étant le centre de la vue ou un noyau
+    typedef struct ReferenceOrbit {
+        double *zr, *zi;
+        int length;         // Nombre de points calculés, le dernier peut s'être échappé ou être Z_p = 0 sur un noyau
+        int capacity;
+
+        // Point C de l'orbite, sa précision et le nombre d'itérations demandé au calcul
+        mpfr_t referenceX, referenceY;
+        mpfr_prec_t precision;
+        int maxIteration;
+        int period;         // Période du noyau pris comme référence, 0 si C est le centre
+
+        // Dernier point Z_length-1 en haute précision, pour prolonger l'orbite
+        mpfr_t lastX, lastY;
+
+        // Ecart du centre de la vue à C, que les pixels ajoutent à leur dc
+        floatexp shiftX, shiftY;
+
+        // Approximation par séries: d_skip = A dc + B dc² + C dc³ pour tous les pixels, (réel, imaginaire)
+        int seriesSkip;     // 0 si pas d'approximation
+        double seriesA[2], seriesB[2], seriesC[2];
+
+        // Approximations bilinéaires, construites seulement avec task->bilinearApproximation
+        BlaTable bla;
+
+        // Correction des glitchs de la dernière image: pixels glitchés et références secondaires utilisées
+        int glitchedPixels;
+        int secondaryReferences;
+
+        // Orbites des vues précédentes
+        OrbitCache cache;
+
+        // Dernière recherche du noyau de l'image, avec task->nucleusReference
+        NucleusSearch nucleusSearch;
+
+        // Calcul en pipeline: les points Z_0 à Z_published-1 sont déjà écrits, length n'est juste qu'une fois complete à 1
+        // published est remis à 0 avant de lancer le calcul, les pixels attendent qu'il passe au-dessus
+        SDL_atomic_t published;
+        SDL_atomic_t complete;
+
+        // Signalé à chaque publication, à la fin de l'orbite et à l'abandon, pour réveiller les pixels qui l'attendent
+        SDL_mutex *publishLock;
+        SDL_cond *publishCond;
+
+        SDL_atomic_t ready; // Passe à 1 quand l'orbite est calculée
+
+        // Passe à 1 pour abandonner le calcul en cours (orbite ou correction des glitchs), remis à 0 avant le suivant
+        SDL_atomic_t cancel;
+    } ReferenceOrbit;
+
+    // Une orbite initialisée doit être libérée
+    void reference_orbit_init(ReferenceOrbit *orbit);
+    void reference_orbit_free(ReferenceOrbit *orbit);
+
+    // Calcule task->reference au centre de la vue de task, ou au noyau de l'image avec task->nucleusReference
+    // en reprenant si possible l'orbite précédente ou une orbite du cache, à lancer dans son propre thread
+    // Avec task->seriesApproximation, cherche aussi le nombre d'itérations que tous les pixels peuvent sauter
+    // Avec task->bilinearApproximation, construit la table BLA si celle gardée ne couvre pas l'image
+    // *task->progress suit l'avancement, orbit->ready passe à 1 quand l'orbite est utilisable
+    // Une orbite longue à calculer est ensuite écrite sur le disque: le thread est à attendre avant de relancer le calcul
+    // orbit->published doit être remis à 0 avant le lancement
+    int compute_reference_orbit(void *arg);
+
+    // Demande à compute_reference_orbit et correct_glitches de s'arrêter au plus tôt, sans attendre
+    // L'orbite garde les points déjà calculés et sera prolongée depuis le dernier, l'image en cours est à jeter
+    // Les pixels perturbés qui attendaient des points de l'orbite n'en attendent plus
+    void reference_orbit_cancel(ReferenceOrbit *orbit);
+
+    // Calcul d'une portion de ligne par perturbation autour de task->reference, exécuté par le pool de threads
+    // Les pixels glitchés valent PERTURBATION_GLITCH
+    // Avec task->pipelinedReference, peut être lancé en même temps que compute_reference_orbit: les pixels
+    // attendent les points de l'orbite au fur et à mesure de son calcul, sans approximation par séries
+    void calculate_iterations_perturbation(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+
+    // Vrai si l'image de task contient des pixels glitchés
+    bool perturbation_has_glitches(const FractalTask *task);
+
+    // Recalcule les pixels glitchés de l'image avec des références secondaires prises dans chaque blob de glitchs,
+    // jusqu'à ce qu'il n'en reste plus, à lancer dans son propre thread une fois les pixels calculés
+    // task->reference->ready passe à 1 à la fin
+    int correct_glitches(void *arg);
+
+    // Même calcul, en sautant des blocs d'itérations avec la table BLA de task->reference
+    void calculate_iterations_bla(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+
+#endif
+
+#endif
@@ -0,0 +1,75 @@
+
+/*
+
+    Pool de threads persistant qui découpe une image en tuiles
+    et les répartit entre les workers par vol de travail
+
+*/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <SDL2/SDL.h>
+
+#include "fractal.h"
+
+// Taille par défaut d'un côté de tuile, en pixels
+#define DEFAULT_TILE_SIZE 32
+
+
+// Etat propre à un worker, les réductions sont faites par le thread principal à la fin du calcul
+typedef struct {
+    int index;
+    int localMax;
+    int64_t iterationsSaved;
+    int64_t pixelsComputed;
+    int64_t fillErrors;
+
+    // Vrai si le dernier pixel calculé par le worker est resté au maximum, la détection de périodicité
+    // n'est faite qu'à côté de tels pixels et reprend ainsi d'une portion de ligne à la suivante
+    bool checkPeriodicity;
+    SDL_atomic_t pixelsDone;
+
+    void *scratch;  // Variables de travail propres au noyau (nombres MPFR...), NULL pour les noyaux double
+
+    // Passe à 1 quand le calcul est abandonné: les portions de ligne restantes ne sont plus calculées
+    // NULL hors du pool
+    SDL_atomic_t *cancel;
+} WorkerContext;
+
+// Calcule le nombre d'itérations des pixels [xStart, xEnd[ de la ligne py dans task->iterationMap
+typedef void (*SpanKernel)(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd);
+
+// Crée ou libère ctx->scratch, appelée par chaque worker au début et à la fin d'un calcul
+typedef void (*ScratchHook)(const FractalTask *task, WorkerContext *ctx);
+
+typedef struct ThreadPool ThreadPool;
+
+
+// Création et destruction du pool, threadCount <= 0 utilise tous les coeurs
+ThreadPool *thread_pool_create(int threadCount, int tileSize);
+void thread_pool_destroy(ThreadPool *pool);
+
+// Lance le calcul de l'image en arrière-plan, retourne dès que le calcul précédent, abandonné s'il n'était pas fini,
+// a rendu ses workers
+void thread_pool_launch(ThreadPool *pool, FractalTask *task, SpanKernel kernel);
+
+// Idem pour un noyau qui a besoin de variables de travail: chaque worker les crée une fois avec
+// createScratch avant sa première tuile et les libère avec destroyScratch après la dernière
+void thread_pool_launch_scratch(ThreadPool *pool, FractalTask *task, SpanKernel kernel,
+                                ScratchHook createScratch, ScratchHook destroyScratch);
+
+// Met à jour *task->progress, et à la fin *task->actual_max, les statistiques et *task->finished
+// Un calcul interrompu n'est jamais donné comme fini
+void thread_pool_update(ThreadPool *pool);
+
+// Attend la fin du calcul en cours
+void thread_pool_wait(ThreadPool *pool);
+
+// Interrompt le calcul en cours au plus tôt: les workers finissent leur portion de ligne et abandonnent le reste
+// La map d'itérations est alors incomplète
+void thread_pool_cancel(ThreadPool *pool);
+
+int thread_pool_thread_count(const ThreadPool *pool);
+
+#endif
@@ -0,0 +1,30 @@
+
+/*
+
+    Parcours d'une tuile de l'image selon le mode de rendu de la tâche,
+    fait par les workers du pool de threads
+
+*/
+
+#ifndef TILE_RENDER_H
+#define TILE_RENDER_H
+
+#include "fractal.h"
+#include "thread_pool.h"
+
+// En dessous de cette taille, l'intérieur d'un rectangle non uniforme est calculé sans le redécouper
+#define SUBDIVIDE_MIN_SIZE 6
+
+// Pas de la grille de pixels intérieurs calculés avant de remplir une zone, en subdivision et en contours
+// Une zone d'une autre valeur plus large que ce pas, entièrement entourée, est ainsi trouvée
+#define FILL_SEED_STEP 16
+
+
+// Calcule les pixels [x0, x1[ x [y0, y1[ avec le noyau, selon task->renderMode
+// Met à jour ctx->localMax et les statistiques du worker
+void render_tile(const FractalTask *task, WorkerContext *ctx, SpanKernel kernel, int x0, int y0, int x1, int y1);
+
+// Nom affiché du mode de rendu
+const char *render_mode_name(RenderMode mode);
+
+#endif
@@ -0,0 +1,76 @@
+
+/*
+
+    Vue sur la fractale: centre et zoom
+
+    Le centre est gardé en MPFR dans la version linux, avec une précision qui
+    suit le zoom pour que deux pixels voisins restent toujours distincts. La
+    version windows, sans MPFR, le garde en double. Le zoom est un floatexp.
+
+*/
+
+#ifndef VIEW_H
+#define VIEW_H
+
+#include <stddef.h>
+
+// Seulement pour la version linux
+#ifdef __linux__
+    #include <mpfr.h>
+#endif
+
+#include "fractal.h"
+#include "floatexp.h"
+
+// Bits du centre en plus de ceux de la taille d'un pixel
+#define VIEW_GUARD_BITS 64
+
+// Décimales affichées au plus pour le centre
+#define VIEW_FORMAT_MAX_DIGITS 60
+
+typedef struct {
+    #ifdef __linux__
+        mpfr_t x, y;
+    #else
+        double x, y;
+    #endif
+    floatexp zoom;
+} FractalView;
+
+
+// Initialisation et libération, toute vue initialisée doit être libérée
+void view_init(FractalView *view, double x, double y, double zoom);
+void view_clear(FractalView *view);
+
+void view_copy(FractalView *dst, const FractalView *src);
+
+// Déplace le centre de (dx, dy) pixels
+void view_move(FractalView *view, double dx, double dy);
+
+// Multiplie le zoom par factor en gardant fixe le point sous le pixel (px, py) d'une fenêtre width x height
+void view_zoom_at(FractalView *view, double factor, int px, int py, int width, int height);
+
+// Position du centre de to dans les pixels de from, relativement au centre de from
+void view_offset_pixels(const FractalView *from, const FractalView *to, double *dx, double *dy);
+
+// Place le centre exactement en (x, y), seulement pour la version linux
+#ifdef __linux__
+    void view_set_center(FractalView *view, mpfr_srcptr x, mpfr_srcptr y);
+#endif
+
+// Centre arrondi en double
+double view_center_x(const FractalView *view);
+double view_center_y(const FractalView *view);
+
+// Saisie au clavier, retourne false si le texte n'est pas un nombre valide
+bool view_set_zoom_text(FractalView *view, const char *text);
+bool view_set_center_x_text(FractalView *view, const char *text);
+bool view_set_center_y_text(FractalView *view, const char *text);
+
+// Ecrit le centre avec assez de chiffres pour le zoom actuel, dans la limite de VIEW_FORMAT_MAX_DIGITS
+void view_format_center(const FractalView *view, char *buffer, size_t size);
+
+// Recopie la vue dans la tâche de calcul
+void view_apply(const FractalView *view, FractalTask *task);
+
+#endif
@@ -29,16 +29,15 @@
     #include <gmp.h>
 #endif
 
-// Etats vrais ou faux
-#define false 0
-#define true 1
-
-// Type des booléens
-#define bool uint8_t
-
-// Retourne la valeur la plus petite ou la plus grande des deux
-#define smallest(a, b) ((a > b) ? (b) : (a))
-#define largest(a, b)  ((a < b) ? (b) : (a))
+#include "fractal.h"
+#include "thread_pool.h"
+#include "kernels.h"
+#include "dispatch.h"
+#include "autotune.h"
+#include "tile_render.h"
+#include "perturbation.h"
+#include "nucleus.h"
+#include "view.h"
 
 // Définit le nombre de fois ou on peut revenir en arrière
 #define MAX_HISTORY 1000
@@ -47,30 +46,6 @@
 #define PALETTE_SIZE 256
 
 
-// Structure de la pile d'historique des zooms
-typedef struct {
-    double zoom;
-    double offsetX;
-    double offsetY;
-} FractalView;
-
-
-// Pour la séparation en un deuxième thread lors du calcul
-typedef struct {
-    int *iterationMap;
-    int max_iteration;
-    int *actual_max;
-    double zoom, offsetX, offsetY;
-    int width, height;
-    bool antialiasing;
-
-    int *progress;  // De 0 à 100
-    bool *finished;
-} FractalTask;
-
-
-
-
 // Pour mieux voir les différents types de menus
 enum menuTypes {
     no_menu = 0,
@@ -101,6 +76,18 @@ typedef enum {
     RAINBOW = 3
 } ColorSchemes;
 
+// Pour les différentes précisions de calcul, haute, perturbation et BLA seulement dans la version linux
+// En automatique, le palier le moins cher qui suffit au zoom est choisi à chaque image
+typedef enum {
+    PRECISION_AUTO,
+    PRECISION_NORMAL,
+    PRECISION_DOUBLE_DOUBLE,
+    PRECISION_HIGH,
+    PRECISION_PERTURBATION,
+    PRECISION_BLA,
+    PRECISION_MODE_COUNT
+} PrecisionMode;
+
 // Liste de l'historique des zooms
 FractalView history[MAX_HISTORY];
 int historyIndex = -1;
@@ -116,25 +103,16 @@ void generate_palette_white_black();
 void generate_palette_rainbow();
 
 // Gestion de l'historique de position de l'image
-void push_view(double zoom, double offsetX, double offsetY);
-bool pop_view(double *zoom, double *offsetX, double *offsetY);
-
-// Calcul de l'image du Mandelbrot
-int calculate_iterations(void* arg);
-#ifdef __linux__
-    int calculate_iterations_high_precision(void* arg);
-#endif
+void push_view(const FractalView *view);
+bool pop_view(FractalView *view);
 
+// Rendu de l'image du Mandelbrot
 void render_iterations(SDL_Renderer *renderer, int *iterationMap, int w, int h, SDL_Color *palette, int max_iteration, int actual_max, bool antialiasing);
 
 
 
-// Calcul des positions sur l'écran par rapport au positions dans la fractale
-void screen_to_fractal(int x, int y, double zoom, double offsetX, double offsetY, int width, int height, double *fx, double *fy);
-
-
 // Dessine la texture du Mandelbrot en prenant une partie d'une texture, et la collant sur une partie d'une autre texture
-void draw_mandelbrot_well_placed(SDL_Renderer *renderer, SDL_Texture *texture, int windowWidth, int windowHeight, double zoom, double lastZoom, double lastOffsetX, double lastOffsetY, double offsetX, double offsetY);
+void draw_mandelbrot_well_placed(SDL_Renderer *renderer, SDL_Texture *texture, int windowWidth, int windowHeight, const FractalView *view, const FractalView *lastView);
 
 
 
@@ -157,22 +135,41 @@ int main(int argc, char *argv[]) {
     // Active ou non l'antialiasing du Mandelbrot
     bool activateAntialiasing = true;
     
-    // Définit si le calcul du mandelbrot sera précis ou normal
+    // Définit si le calcul du mandelbrot sera normal, en double-double, précis, ou par perturbation autour d'une orbite précise, avec ou sans BLA
+    // ou choisi automatiquement d'après le zoom
+    PrecisionMode precisionMode = PRECISION_AUTO;
+
+    // Précision effectivement utilisée par le dernier calcul lancé
+    PrecisionMode activeMode = PRECISION_NORMAL;
+
     // Seulement dans la version linux
     #ifdef __linux__
-        bool advancedMode = false;
+        // En perturbation, fait démarrer les pixels après les itérations qu'une série prévoit correctement
+        bool seriesApproximation = true;
+
+        // En perturbation, prend comme orbite de référence le noyau de plus petite période près de l'image
+        bool nucleusReference = true;
+
+        // En perturbation, les pixels démarrent pendant le calcul de l'orbite de référence au lieu de l'attendre
+        bool pipelinedReference = false;
     #endif
     
     // Si activé, la mise à jour auto du mandelbrot au modification de zoom et d'offset ne se fonts plus
     bool activateAutoRefresh = false;
+
+    // Parcours des tuiles: tous les pixels ou subdivision des rectangles uniformes
+    RenderMode renderMode = RENDER_PIXELS;
+
+    // Si activé, les pixels remplis par la subdivision ou le suivi de contours sont quand même calculés pour compter les erreurs
+    bool verifyFills = false;
     
     // Donne le nombre d'itérations jusqu'a lequel on va a chaque calcul de pixel du mandelbrot
     int max_iteration = 200;
 
     // Valeur de zoom et d'offset par défaut (position de départ)
-    double zoom = 200.0;
-    double offsetX = -0.5;
-    double offsetY = 0.0;
+    // Le centre est en haute précision et le zoom un floatexp, voir view.h
+    FractalView view;
+    view_init(&view, -0.5, 0.0, 200.0);
     
     // Définit les couleurs utilisées
     int colorScheme = HOT_COLD;
@@ -203,12 +200,15 @@ int main(int argc, char *argv[]) {
     bool firstExecution = true;
     
     // Valeur ou on enregistre les derniers zooms et déplacements
-    double lastZoom = zoom;
-    double lastOffsetX = offsetX;
-    double lastOffsetY = offsetY;
-    double lastZoomSave = zoom;
-    double lastOffsetXSave = offsetX;
-    double lastOffsetYSave = offsetY;
+    FractalView lastView, lastViewSave;
+    view_init(&lastView, 0.0, 0.0, 1.0);
+    view_init(&lastViewSave, 0.0, 0.0, 1.0);
+    view_copy(&lastView, &view);
+    view_copy(&lastViewSave, &view);
+
+    for (int i = 0; i < MAX_HISTORY; i++) {
+        view_init(&history[i], 0.0, 0.0, 1.0);
+    }
 
     
     // Variables permettant de suivre les demandes de dessin
@@ -227,9 +227,9 @@ int main(int argc, char *argv[]) {
     uint8_t menuMode = 0;
     
     // Buffer de texte d'entrée et de sortie
-    char inputBuffer[100];
+    char inputBuffer[512];
     bool inputStringModified = false;
-    char displayBuffer[160];
+    char displayBuffer[1024];
     
     // Retient le type de la dernière action utilisateur, sert a limiter le nombre de choses qu'on met dans l'historique
     int lastActionType = 0;
@@ -264,6 +264,35 @@ int main(int argc, char *argv[]) {
     
     SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
 
+    // Réglage du calcul pour cette machine: relu depuis le fichier local, sinon mesuré
+    // --autotune force de nouvelles mesures, --no-autotune garde le réglage par défaut
+    bool forceAutotune = false;
+    bool skipAutotune = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--autotune") == 0)
+            forceAutotune = true;
+        else if (strcmp(argv[i], "--no-autotune") == 0)
+            skipAutotune = true;
+    }
+
+    TuneConfig tune;
+    if (skipAutotune) {
+        default_tune_config(&tune);
+    } else if (forceAutotune || !load_tune_config(TUNE_CONFIG_PATH, &tune)) {
+        autotune(&tune);
+        save_tune_config(TUNE_CONFIG_PATH, &tune);
+    }
+
+    // Workers persistants qui se partagent le calcul de chaque image
+    ThreadPool *pool = thread_pool_create(tune.threadCount, tune.tileSize);
+
+    // Noyau vectorisé choisi selon les instructions disponibles sur le processeur
+    SpanKernel doubleKernel = find_double_kernel(tune.kernel)->kernel;
+    SpanKernel doubleDoubleKernel = best_double_double_kernel()->kernel;
+
+    // Noyau des calculs qui reprennent le précédent avec plus d'itérations
+    SpanKernel resumeKernel = resumable_double_kernel(find_double_kernel(tune.kernel))->kernel;
+
     // Ce qui va contenir tout la texture de la fractale
     SDL_Texture *fractalTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, windowWidth, windowHeight);
 
@@ -275,19 +304,67 @@ int main(int argc, char *argv[]) {
     int progress = 0;
     int lastProgress = 0;
     bool finished = false;
+    int64_t iterationsSaved = 0;
+    int64_t pixelsComputed = 0;
+    int64_t fillErrors = 0;
+
+    // Orbite de référence pour la perturbation (centre de la vue ou noyau proche), calculée dans son propre thread avant les pixels
+    // En pipeline, les pixels peuvent finir avant elle: pixelsDone attend alors qu'elle soit prête
+    #ifdef __linux__
+        ReferenceOrbit reference;
+        reference_orbit_init(&reference);
+        bool referencePending = false;
+        bool glitchPending = false;
+        bool pixelsDone = false;
+
+        // Threads de l'orbite de référence et de la correction des glitchs, attendus quand ils ont fini ou à la fermeture
+        SDL_Thread *referenceThread = NULL;
+        SDL_Thread *glitchThread = NULL;
+
+        // Recherche du noyau demandée avec la touche G, hors du thread principal et de la tâche
+        NucleusJob nucleusJob;
+        nucleus_job_init(&nucleusJob);
+        SDL_Thread *nucleusThread = NULL;
+    #endif
     
     FractalTask task;
     task.iterationMap = malloc(windowWidth * windowHeight * sizeof(int));
     task.max_iteration = 0;
     task.actual_max = &actual_max;
     task.zoom = 0;
+    task.pixelSize = fe_from_double(0.0);
     task.offsetX = 0;
     task.offsetY = 0;
+    #ifdef __linux__
+        mpfr_init2(task.centerX, 53);
+        mpfr_init2(task.centerY, 53);
+    #endif
     task.width = 0;
     task.height = 0;
     task.antialiasing = false;
     task.progress = &progress;
     task.finished = &finished;
+    task.renderMode = RENDER_PIXELS;
+    task.verifyFills = false;
+    task.seriesApproximation = false;
+    task.bilinearApproximation = false;
+    task.nucleusReference = false;
+    task.pipelinedReference = false;
+    #ifdef __linux__
+        task.reference = &reference;
+    #else
+        task.reference = NULL;
+    #endif
+    task.iterationsSaved = &iterationsSaved;
+    task.pixelsComputed = &pixelsComputed;
+    task.fillErrors = &fillErrors;
+
+    // Etat des pixels arrêtés au maximum, donné à la tâche seulement pour les calculs en double
+    double *resumeX = malloc(windowWidth * windowHeight * sizeof(double));
+    double *resumeY = malloc(windowWidth * windowHeight * sizeof(double));
+    task.resumeX = NULL;
+    task.resumeY = NULL;
+    task.resumeFrom = 0;
 
 
     // Génère la palette de couleurs qui va servir à colorer le mandelbrot
@@ -351,7 +428,7 @@ int main(int argc, char *argv[]) {
             }
             // Revient en arrière dans l'historique sur clic gauche
             if (event.type == SDL_MOUSEBUTTONUP && event.button.button == SDL_BUTTON_RIGHT && !rightDragging && initialClickDone && !menuMode) {
-                if (pop_view(&zoom, &offsetX, &offsetY)) {
+                if (pop_view(&view)) {
                     redrawInterface = true;
                     queryCalculateImage = true;
                 }
@@ -368,31 +445,19 @@ int main(int argc, char *argv[]) {
                 int mouseX, mouseY;
                 SDL_GetMouseState(&mouseX, &mouseY);
 
-                // 2. Position fractale AVANT zoom
-                double fx_before, fy_before;
-                screen_to_fractal(mouseX, mouseY, zoom, offsetX, offsetY, windowWidth, windowHeight, &fx_before, &fy_before);
-
-                // 3. Mémoriser le type d’action (historique)
+                // 2. Mémoriser le type d’action (historique)
                 if (event.type != lastActionType) {
-                    push_view(zoom, offsetX, offsetY);
+                    push_view(&view);
                     lastActionType = SDL_MOUSEWHEEL;
                 }
 
-                // 4. Modifier le zoom
+                // 3. Modifier le zoom en restant centré sur la souris
                 if (event.wheel.y > 0) {
-                    zoom *= 1.3;
+                    view_zoom_at(&view, 1.3, mouseX, mouseY, windowWidth, windowHeight);
                 } else if (event.wheel.y < 0) {
-                    zoom /= 1.3;
+                    view_zoom_at(&view, 1 / 1.3, mouseX, mouseY, windowWidth, windowHeight);
                 }
 
-                // 5. Position fractale APRÈS zoom
-                double fx_after, fy_after;
-                screen_to_fractal(mouseX, mouseY, zoom, offsetX, offsetY, windowWidth, windowHeight, &fx_after, &fy_after);
-
-                // 6. Calcul du delta de déplacement (on veut rester centré sur la souris)
-                offsetX += fx_before - fx_after;
-                offsetY += fy_before - fy_after;
-
                 redrawInterface = true;
                 queryCalculateImage = true;
             }
@@ -402,55 +467,55 @@ int main(int argc, char *argv[]) {
                     case SDLK_UP:
                         // Si on vient de changer d'action de mouvement, enregistrer la position dans l'historique
                         if (event.type != lastActionType || event.key.keysym.sym != lastActionValue) {
-                            push_view(zoom, offsetX, offsetY);
+                            push_view(&view);
                             lastActionType = SDL_KEYDOWN;
                             lastActionValue = event.key.keysym.sym;
                         }
-                        offsetY -= 80 / zoom;
+                        view_move(&view, 0, -80);
                         redrawInterface = true;
                         break;
                     // Flêche bas
                     case SDLK_DOWN:
                         // Si on vient de changer d'action de mouvement, enregistrer la position dans l'historique
                         if (event.type != lastActionType || event.key.keysym.sym != lastActionValue) {
-                            push_view(zoom, offsetX, offsetY);
+                            push_view(&view);
                             lastActionType = SDL_KEYDOWN;
                             lastActionValue = event.key.keysym.sym;
                         }
-                        offsetY += 80 / zoom;
+                        view_move(&view, 0, 80);
                         redrawInterface = true;
                         break;
                     // Flêche gauche
                     case SDLK_LEFT:
                         // Si on vient de changer d'action de mouvement, enregistrer la position dans l'historique
                         if (event.type != lastActionType || event.key.keysym.sym != lastActionValue) {
-                            push_view(zoom, offsetX, offsetY);
+                            push_view(&view);
                             lastActionType = SDL_KEYDOWN;
                             lastActionValue = event.key.keysym.sym;
                         }
-                        offsetX -= 80 / zoom;
+                        view_move(&view, -80, 0);
                         redrawInterface = true;
                         break;
                     // Flêche droite
                     case SDLK_RIGHT:
                         // Si on vient de changer d'action de mouvement, enregistrer la position dans l'historique
                         if (event.type != lastActionType || event.key.keysym.sym != lastActionValue) {
-                            push_view(zoom, offsetX, offsetY);
+                            push_view(&view);
                             lastActionType = SDL_KEYDOWN;
                             lastActionValue = event.key.keysym.sym;
                         }
-                        offsetX += 80 / zoom;
+                        view_move(&view, 80, 0);
                         redrawInterface = true;
                         break;
                     // Touche égal (+)
                     case SDLK_EQUALS:
                         // Si on vient de changer d'action de mouvement, enregistrer la position dans l'historique
                         if (event.type != lastActionType || event.key.keysym.sym != lastActionValue) {
-                            push_view(zoom, offsetX, offsetY);
+                            push_view(&view);
                             lastActionType = SDL_KEYDOWN;
                             lastActionValue = event.key.keysym.sym;
                         }
-                        zoom *= 1.6;
+                        view_zoom_at(&view, 1.6, windowWidth / 2, windowHeight / 2, windowWidth, windowHeight);
                         redrawInterface = true;
                         queryCalculateImage = true;
                         break;
@@ -458,11 +523,11 @@ int main(int argc, char *argv[]) {
                     case SDLK_MINUS:
                         // Si on vient de changer d'action de mouvement, enregistrer la position dans l'historique
                         if (event.type != lastActionType || event.key.keysym.sym != lastActionValue) {
-                            push_view(zoom, offsetX, offsetY);
+                            push_view(&view);
                             lastActionType = SDL_KEYDOWN;
                             lastActionValue = event.key.keysym.sym;
                         }
-                        zoom /= 1.6;
+                        view_zoom_at(&view, 1 / 1.6, windowWidth / 2, windowHeight / 2, windowWidth, windowHeight);
                         redrawInterface = true;
                         queryCalculateImage = true;
                         break;
@@ -503,14 +568,60 @@ int main(int argc, char *argv[]) {
                         activateAutoRefresh = !activateAutoRefresh;
                         redrawInterface = true;
                         break;
+                    case SDLK_m:
+                        // Précisions parcourues avec la touche M, en commençant par l'automatique, celles à partir de la haute précision seulement dans la version linux
+                        #ifdef __linux__
+                            precisionMode = (precisionMode + 1) % PRECISION_MODE_COUNT;
+                        #else
+                            precisionMode = (precisionMode + 1) % PRECISION_HIGH;
+                        #endif
+                        redrawInterface = true;
+                        queryCalculateImage = true;
+                        break;
                     #ifdef __linux__
-                        case SDLK_m:
-                            // Précision complexe seulement dans la version linux avec la touche M
-                            advancedMode = !advancedMode;
+                        case SDLK_a:
+                            // Toggle pour l'approximation par séries de la perturbation avec la touche A
+                            seriesApproximation = !seriesApproximation;
                             redrawInterface = true;
                             queryCalculateImage = true;
                             break;
+                        case SDLK_n:
+                            // Toggle pour la référence sur un noyau de la perturbation avec la touche N
+                            nucleusReference = !nucleusReference;
+                            redrawInterface = true;
+                            queryCalculateImage = true;
+                            break;
+                        case SDLK_p:
+                            // Toggle pour le calcul des pixels perturbés en même temps que l'orbite de référence avec la touche P
+                            pipelinedReference = !pipelinedReference;
+                            redrawInterface = true;
+                            queryCalculateImage = true;
+                            break;
+                        case SDLK_g:
+                            // Touche G pour centrer la vue sur le noyau de plus petite période près de l'image
+                            // La recherche se fait dans son propre thread, la vue sera recentrée quand elle aura fini
+                            if (!nucleusThread) {
+                                nucleusJob.task.max_iteration = max_iteration;
+                                nucleusJob.task.width = windowWidth;
+                                nucleusJob.task.height = windowHeight;
+                                view_apply(&view, &nucleusJob.task);
+                                SDL_AtomicSet(&nucleusJob.done, 0);
+                                nucleusThread = SDL_CreateThread(nucleus_job_run, "NucleusThread", &nucleusJob);
+                            }
+                            break;
                     #endif
+                    case SDLK_s:
+                        // Touche S pour parcourir les modes de rendu
+                        renderMode = (renderMode + 1) % RENDER_MODE_COUNT;
+                        redrawInterface = true;
+                        queryCalculateImage = true;
+                        break;
+                    case SDLK_v:
+                        // Toggle pour vérifier les remplissages de la subdivision avec la touche V
+                        verifyFills = !verifyFills;
+                        redrawInterface = true;
+                        queryCalculateImage = true;
+                        break;
                     case SDLK_b:
                         // Touche B pour parcourir les couleurs de palettes
                         switch (colorScheme) {
@@ -567,14 +678,13 @@ int main(int argc, char *argv[]) {
                     leftDragging = true; // on considère que c’est un vrai glissement
                     // Sauvegarde dans l'historique au début du drag
                     if (event.type != lastActionType) {
-                        push_view(zoom, offsetX, offsetY);
+                        push_view(&view);
                         lastActionType = event.type;
                     }
                 }
 
                 if (leftDragging) {
-                    offsetX -= dx / zoom;
-                    offsetY -= dy / zoom;
+                    view_move(&view, -dx, -dy);
                     leftClickStartX = event.motion.x; // mettre à jour pour les prochains deltas
                     leftClickStartY = event.motion.y;
                     redrawInterface = true;
@@ -605,7 +715,7 @@ int main(int argc, char *argv[]) {
                 rightSelecting = false;
                 rightDragging = false;
                 
-                push_view(zoom, offsetX, offsetY);
+                push_view(&view);
 
                 int x1 = smallest(selectStart.x, selectEnd.x);
                 int x2 = largest(selectStart.x, selectEnd.x);
@@ -613,13 +723,11 @@ int main(int argc, char *argv[]) {
                 int y2 = largest(selectStart.y, selectEnd.y);
 
                 if (abs(x2 - x1) > 10 && abs(y2 - y1) > 10) {
-                    double fx1, fy1, fx2, fy2;
-                    screen_to_fractal(x1, y1, zoom, offsetX, offsetY, windowWidth, windowHeight, &fx1, &fy1);
-                    screen_to_fractal(x2, y2, zoom, offsetX, offsetY, windowWidth, windowHeight, &fx2, &fy2);
-
-                    offsetX = (fx1 + fx2) / 2;
-                    offsetY = (fy1 + fy2) / 2;
-                    zoom *= fmin(windowWidth / (double)(x2 - x1), windowHeight / (double)(y2 - y1));
+                    // Centre de la sélection, puis zoom autour de lui
+                    view_move(&view, ((x1 - windowWidth / 2) + (x2 - windowWidth / 2)) / 2.0,
+                                     ((y1 - windowHeight / 2) + (y2 - windowHeight / 2)) / 2.0);
+                    view_zoom_at(&view, fmin(windowWidth / (double)(x2 - x1), windowHeight / (double)(y2 - y1)),
+                                 windowWidth / 2, windowHeight / 2, windowWidth, windowHeight);
                 }
                 
                 redrawInterface = true;
@@ -665,9 +773,16 @@ int main(int argc, char *argv[]) {
                                 inputStringModified = true;
                                 redrawImage = true;
                             }
-                            else if (c == '-' && len == 0) {
-                                inputBuffer[0] = '-';
-                                inputBuffer[1] = '\0';
+                            else if (c == '-' && (len == 0 || inputBuffer[len - 1] == 'e')) {
+                                inputBuffer[len] = '-';
+                                inputBuffer[len + 1] = '\0';
+                                inputStringModified = true;
+                                redrawImage = true;
+                            }
+                            else if ((c == 'e' || c == 'E') && hasDigit && !strchr(inputBuffer, 'e')) {
+                                // Notation scientifique, pour les zooms profonds
+                                inputBuffer[len] = 'e';
+                                inputBuffer[len + 1] = '\0';
                                 inputStringModified = true;
                                 redrawImage = true;
                             }
@@ -684,29 +799,35 @@ int main(int argc, char *argv[]) {
                         }
                     }
 
-                    // Conversion sécurisée avec strtod
-                    char *endptr;
-                    double value = strtod(inputBuffer, &endptr);
-
-                    if (*endptr == '\0') {  // conversion réussie
+                    // Le zoom et le centre sont lus avec tous leurs chiffres par la vue
+                    bool valid = false;
+                    switch (menuMode) {
+                        case max_iteration_menu: {
+                            // Conversion sécurisée avec strtod
+                            char *endptr;
+                            double value = strtod(inputBuffer, &endptr);
 
-                        switch (menuMode) {
-                            case max_iteration_menu:
+                            valid = *endptr == '\0';
+                            if (valid) {
                                 if ((int)(value + 0.5) < 1) {
                                     value = 1;
                                 }
                                 max_iteration = (int)(value + 0.5);  // arrondi au plus proche
-                                break;
-                            case zoom_menu:
-                                zoom = value;
-                                break;
-                            case offsetX_menu:
-                                offsetX = value;
-                                break;
-                            case offsetY_menu:
-                                offsetY = value;
-                                break;
+                            }
+                            break;
                         }
+                        case zoom_menu:
+                            valid = view_set_zoom_text(&view, inputBuffer);
+                            break;
+                        case offsetX_menu:
+                            valid = view_set_center_x_text(&view, inputBuffer);
+                            break;
+                        case offsetY_menu:
+                            valid = view_set_center_y_text(&view, inputBuffer);
+                            break;
+                    }
+
+                    if (valid) {  // conversion réussie
 
                         menuMode = no_menu;
                         SDL_StopTextInput();
@@ -740,6 +861,20 @@ int main(int argc, char *argv[]) {
             }
         }
 
+        // Recherche du noyau finie: la vue est recentrée dessus
+        #ifdef __linux__
+            if (nucleusThread && SDL_AtomicGet(&nucleusJob.done)) {
+                SDL_WaitThread(nucleusThread, NULL);
+                nucleusThread = NULL;
+                if (nucleusJob.found) {
+                    push_view(&view);
+                    view_set_center(&view, nucleusJob.x, nucleusJob.y);
+                    redrawInterface = true;
+                    queryCalculateImage = true;
+                }
+            }
+        #endif
+
         if (queryCalculateImage && activateAutoRefresh) {
             calculateImage = true;
         }
@@ -747,6 +882,43 @@ int main(int argc, char *argv[]) {
         // Si on est en attente du dessin de la fractale
         if (fractalCalcPending) {
         
+            // Orbite de référence prête: les workers calculent maintenant les pixels par perturbation
+            #ifdef __linux__
+                // Le thread écrit peut-être encore l'orbite sur le disque: il est attendu à l'image suivante
+                if (referencePending && SDL_AtomicGet(&reference.ready)) {
+                    referencePending = false;
+                    if (task.pipelinedReference)
+                        finished = pixelsDone;
+                    else
+                        thread_pool_launch(pool, &task, activeMode == PRECISION_BLA ? calculate_iterations_bla : calculate_iterations_perturbation);
+                }
+            #endif
+
+            // Récupère l'avancement des workers
+            thread_pool_update(pool);
+
+            #ifdef __linux__
+                if (referencePending && finished) {
+                    finished = false;
+                    pixelsDone = true;
+                }
+            #endif
+
+            // Pixels perturbés glitchés: corrigés avec des références secondaires dans leur propre thread
+            #ifdef __linux__
+                if (glitchPending && SDL_AtomicGet(&reference.ready)) {
+                    glitchPending = false;
+                    SDL_WaitThread(glitchThread, NULL);
+                    glitchThread = NULL;
+                    finished = true;
+                } else if (finished && !glitchPending && !referencePending && activeMode == PRECISION_PERTURBATION && perturbation_has_glitches(&task)) {
+                    finished = false;
+                    glitchPending = true;
+                    SDL_AtomicSet(&reference.ready, 0);
+                    glitchThread = SDL_CreateThread(correct_glitches, "GlitchThread", &task);
+                }
+            #endif
+
             if (redrawInterface) {
                 redrawLoading = true;
             }
@@ -766,9 +938,7 @@ int main(int argc, char *argv[]) {
                 // On lance le rendu en couleur des calculs
                 renderIterations = true;
                 
-                lastZoom = lastZoomSave;
-                lastOffsetX = lastOffsetXSave;
-                lastOffsetY = lastOffsetYSave;
+                view_copy(&lastView, &lastViewSave);
   
                 redrawInterface = true;    
                 fractalCalcPending = false;  
@@ -803,11 +973,43 @@ int main(int argc, char *argv[]) {
         // Si on modifie la vue et qu'on demande un recalcul, ou qu'on force un recalcul
         if (calculateImage) {
 
+            // Calcul précédent encore en cours (workers, orbite de référence, correction des glitchs): abandonné et
+            // attendu avant de toucher à la tâche, ils lisent son centre MPFR, son zoom... et écrivent dans ses maps
+            if (fractalCalcPending) {
+                #ifdef __linux__
+                    // L'orbite d'abord, pour libérer les workers qui l'attendent
+                    reference_orbit_cancel(&reference);
+                #endif
+                thread_pool_cancel(pool);
+            }
+            #ifdef __linux__
+                if (referenceThread || glitchThread) {
+                    reference_orbit_cancel(&reference);
+                    if (referenceThread) {
+                        SDL_WaitThread(referenceThread, NULL);
+                        referenceThread = NULL;
+                    }
+                    if (glitchThread) {
+                        SDL_WaitThread(glitchThread, NULL);
+                        glitchThread = NULL;
+                    }
+                    referencePending = false;
+                    glitchPending = false;
+                }
+            #endif
+            if (fractalCalcPending) {
+                thread_pool_wait(pool);
+                // Itérations et états de reprise incomplets: le prochain calcul repart de zéro
+                task.resumeX = NULL;
+                task.resumeY = NULL;
+                fractalCalcPending = false;
+            }
+
             // Sélectionne l'écran comme cible            
             SDL_SetRenderTarget(renderer, NULL);
 
             // Imprime la texture du Mandelbrot correctement placée par rapport au zoom et à l'offset
-            draw_mandelbrot_well_placed(renderer, fractalTexture, windowWidth, windowHeight, zoom, lastZoom, lastOffsetX, lastOffsetY, offsetX, offsetY);
+            draw_mandelbrot_well_placed(renderer, fractalTexture, windowWidth, windowHeight, &view, &lastView);
             
             // 1. Sauvegarder l’ancienne texture et sa taille
             int oldW, oldH;
@@ -841,24 +1043,92 @@ int main(int argc, char *argv[]) {
                 // Actualiser la taille de la map d'itérations
                 free(task.iterationMap);
                 task.iterationMap = malloc(windowWidth * windowHeight * sizeof(int));
+                free(resumeX);
+                free(resumeY);
+                resumeX = malloc(windowWidth * windowHeight * sizeof(double));
+                resumeY = malloc(windowWidth * windowHeight * sizeof(double));
             }
-            
+
+            // Copie du calcul précédent, seulement pour comparer ses paramètres
+            FractalTask previous = task;
+
             task.max_iteration = max_iteration;
-            task.zoom = zoom;
-            task.offsetX = offsetX;
-            task.offsetY = offsetY;
+            view_apply(&view, &task);
             task.width = windowWidth;
             task.height = windowHeight;
             task.antialiasing = activateAntialiasing;
+            task.renderMode = renderMode;
+            task.verifyFills = verifyFills;
+
+            // En automatique, la précision de ce calcul dépend du zoom et de la taille de la fenêtre
+            activeMode = precisionMode;
+            if (precisionMode == PRECISION_AUTO) {
+                switch (cheapest_precision_tier(&task)) {
+                    case TIER_HIGH:
+                        activeMode = PRECISION_HIGH;
+                        break;
+                    case TIER_DOUBLE_DOUBLE:
+                        activeMode = PRECISION_DOUBLE_DOUBLE;
+                        break;
+                    default:
+                        activeMode = PRECISION_NORMAL;
+                }
+            }
+
+            // Seul max_iteration a augmenté depuis le calcul en double précédent: les pixels échappés gardent leur
+            // résultat, ceux arrêtés à l'ancien maximum reprennent depuis leur état
+            task.resumeX = activeMode == PRECISION_NORMAL ? resumeX : NULL;
+            task.resumeY = activeMode == PRECISION_NORMAL ? resumeY : NULL;
+            task.resumeFrom = 0;
+            if (task.resumeX && previous.resumeX && task.max_iteration > previous.max_iteration
+                && task.zoom == previous.zoom && task.offsetX == previous.offsetX && task.offsetY == previous.offsetY
+                && task.width == previous.width && task.height == previous.height
+                && task.renderMode == previous.renderMode && task.verifyFills == previous.verifyFills)
+                task.resumeFrom = previous.max_iteration;
 
             #ifdef __linux__
-                if (advancedMode) {
-                    SDL_CreateThread(calculate_iterations_high_precision, "CalcFractalThread", &task);
-                } else {
-                    SDL_CreateThread(calculate_iterations, "CalcFractalThread", &task);
+                task.seriesApproximation = seriesApproximation && activeMode == PRECISION_PERTURBATION;
+                task.bilinearApproximation = activeMode == PRECISION_BLA;
+                task.nucleusReference = nucleusReference;
+                task.pipelinedReference = pipelinedReference && activeMode == PRECISION_PERTURBATION;
+            #endif
+
+            #ifdef __linux__
+                switch (activeMode) {
+                    case PRECISION_HIGH:
+                        // Virgule fixe sur le pool tant que la précision tient en 8 limbs, MPFR au-delà
+                        if (fixed_point_kernel(&task)) {
+                            thread_pool_launch(pool, &task, fixed_point_kernel(&task));
+                        } else {
+                            thread_pool_launch_scratch(pool, &task, calculate_iterations_high_precision_span,
+                                                       high_precision_scratch_create, high_precision_scratch_destroy);
+                        }
+                        break;
+                    case PRECISION_PERTURBATION:
+                    case PRECISION_BLA:
+                        // L'orbite de référence (et la table BLA) d'abord, les pixels seront donnés au pool quand elle sera prête
+                        // En pipeline, le pool démarre tout de suite et suit l'orbite pendant son calcul
+                        finished = false;
+                        pixelsDone = false;
+                        SDL_AtomicSet(&reference.ready, 0);
+                        SDL_AtomicSet(&reference.published, 0);
+                        SDL_AtomicSet(&reference.cancel, 0);
+                        referencePending = true;
+                        referenceThread = SDL_CreateThread(compute_reference_orbit, "CalcReferenceThread", &task);
+                        if (task.pipelinedReference)
+                            thread_pool_launch(pool, &task, calculate_iterations_perturbation);
+                        break;
+                    case PRECISION_DOUBLE_DOUBLE:
+                        thread_pool_launch(pool, &task, doubleDoubleKernel);
+                        break;
+                    default:
+                        thread_pool_launch(pool, &task, task.resumeFrom > 0 ? resumeKernel : doubleKernel);
                 }
             #else
-                SDL_CreateThread(calculate_iterations, "CalcFractalThread", &task);
+                if (activeMode == PRECISION_DOUBLE_DOUBLE)
+                    thread_pool_launch(pool, &task, doubleDoubleKernel);
+                else
+                    thread_pool_launch(pool, &task, task.resumeFrom > 0 ? resumeKernel : doubleKernel);
             #endif
             
 
@@ -868,9 +1138,7 @@ int main(int argc, char *argv[]) {
             lastProgress = 1000;
             
             // Sauvegarde les dernière valeurs de zoom et d'offset
-            lastZoomSave = zoom;
-            lastOffsetXSave = offsetX;
-            lastOffsetYSave = offsetY;
+            view_copy(&lastViewSave, &view);
         }
 
         if (redrawImage || redrawInterface || calculateImage) {
@@ -878,8 +1146,7 @@ int main(int argc, char *argv[]) {
             SDL_SetRenderTarget(renderer, NULL);
 
             // Dessine avec les offsets temporaires
-            draw_mandelbrot_well_placed(renderer, fractalTexture, windowWidth, windowHeight, zoom,
-                                         lastZoom, lastOffsetX, lastOffsetY, offsetX, offsetY);
+            draw_mandelbrot_well_placed(renderer, fractalTexture, windowWidth, windowHeight, &view, &lastView);
 
             drawingMade = true;
         }
@@ -897,17 +1164,98 @@ int main(int argc, char *argv[]) {
             // Paramètres de l'image, bord bas gauche
             sprintf(displayBuffer, "Nombre d'itérations max: %d", max_iteration);
             render_text(renderer, font, displayBuffer, 10, windowHeight - verticalSpacing, ORIGIN_UP_LEFT);
-            sprintf(displayBuffer, "Zoom actuel: %f", zoom);
+            char zoomText[32];
+            fe_format(zoomText, sizeof(zoomText), view.zoom);
+            sprintf(displayBuffer, "Zoom actuel: %s", zoomText);
             render_text(renderer, font, displayBuffer, 10, windowHeight - 2 * verticalSpacing, ORIGIN_UP_LEFT);
-            sprintf(displayBuffer, "Offset actuel: X: %f   Y: %f", offsetX, offsetY);
+            char centerText[sizeof(displayBuffer) - 32];
+            view_format_center(&view, centerText, sizeof(centerText));
+            sprintf(displayBuffer, "Offset actuel: %s", centerText);
             render_text(renderer, font, displayBuffer, 10, windowHeight - 3 * verticalSpacing, ORIGIN_UP_LEFT);
+            sprintf(displayBuffer, "Itérations évitées (périodicité): %lld", (long long)iterationsSaved);
+            render_text(renderer, font, displayBuffer, 10, windowHeight - 4 * verticalSpacing, ORIGIN_UP_LEFT);
+            sprintf(displayBuffer, "Pixels calculés: %lld (%.1f%%)", (long long)pixelsComputed,
+                    task.width > 0 ? pixelsComputed * 100.0 / ((double)task.width * task.height) : 0.0);
+            render_text(renderer, font, displayBuffer, 10, windowHeight - 5 * verticalSpacing, ORIGIN_UP_LEFT);
+            if (verifyFills && renderMode != RENDER_PIXELS) {
+                sprintf(displayBuffer, "Pixels remplis à tort: %lld", (long long)fillErrors);
+                render_text(renderer, font, displayBuffer, 10, windowHeight - 6 * verticalSpacing, ORIGIN_UP_LEFT);
+            }
+            #ifdef __linux__
+                if (activeMode == PRECISION_PERTURBATION && !fractalCalcPending) {
+                    sprintf(displayBuffer, "Itérations sautées (séries): %d / longueur de l'orbite de référence: %d", reference.seriesSkip, reference.length);
+                    render_text(renderer, font, displayBuffer, 10, windowHeight - 7 * verticalSpacing, ORIGIN_UP_LEFT);
+                    sprintf(displayBuffer, "Pixels glitchés corrigés: %d / références secondaires: %d", reference.glitchedPixels, reference.secondaryReferences);
+                    render_text(renderer, font, displayBuffer, 10, windowHeight - 9 * verticalSpacing, ORIGIN_UP_LEFT);
+                }
+                if (activeMode == PRECISION_BLA && !fractalCalcPending) {
+                    sprintf(displayBuffer, "Table BLA: %d niveaux / longueur de l'orbite de référence: %d", reference.bla.levels, reference.length);
+                    render_text(renderer, font, displayBuffer, 10, windowHeight - 7 * verticalSpacing, ORIGIN_UP_LEFT);
+                }
+                if (activeMode == PRECISION_HIGH && fixed_point_limbs(&task) > 0) {
+                    sprintf(displayBuffer, "Précision: %ld bits (virgule fixe, %d limbs)", (long)high_precision_bits(&task), fixed_point_limbs(&task));
+                    render_text(renderer, font, displayBuffer, 10, windowHeight - 7 * verticalSpacing, ORIGIN_UP_LEFT);
+                } else if (activeMode == PRECISION_HIGH) {
+                    sprintf(displayBuffer, "Précision MPFR: %ld bits", (long)high_precision_bits(&task));
+                    render_text(renderer, font, displayBuffer, 10, windowHeight - 7 * verticalSpacing, ORIGIN_UP_LEFT);
+                }
+                if ((activeMode == PRECISION_PERTURBATION || activeMode == PRECISION_BLA) && !fractalCalcPending) {
+                    if (reference.period > 0)
+                        sprintf(displayBuffer, "Précision de l'orbite de référence: %ld bits (noyau de période %d)", (long)reference.precision, reference.period);
+                    else
+                        sprintf(displayBuffer, "Précision de l'orbite de référence: %ld bits", (long)reference.precision);
+                    render_text(renderer, font, displayBuffer, 10, windowHeight - 8 * verticalSpacing, ORIGIN_UP_LEFT);
+                }
+            #endif
 
             // Controles, bord bas droite
+            // En automatique, le palier choisi est affiché à la place du mode
+            if (precisionMode == PRECISION_AUTO) {
+                switch (activeMode) {
+                    case PRECISION_HIGH:
+                        render_text(renderer, font, "M pour changer la précision:          AUTO (HAUTE)", windowWidth - 10, windowHeight - 10 * verticalSpacing, ORIGIN_UP_RIGHT);
+                        break;
+                    case PRECISION_DOUBLE_DOUBLE:
+                        render_text(renderer, font, "M pour changer la précision:  AUTO (DOUBLE-DOUBLE)", windowWidth - 10, windowHeight - 10 * verticalSpacing, ORIGIN_UP_RIGHT);
+                        break;
+                    default:
+                        render_text(renderer, font, "M pour changer la précision:        AUTO (NORMALE)", windowWidth - 10, windowHeight - 10 * verticalSpacing, ORIGIN_UP_RIGHT);
+                }
+            } else {
+                switch (precisionMode) {
+                    case PRECISION_HIGH:
+                        render_text(renderer, font, "M pour changer la précision:        HAUTE", windowWidth - 10, windowHeight - 10 * verticalSpacing, ORIGIN_UP_RIGHT);
+                        break;
+                    case PRECISION_PERTURBATION:
+                        render_text(renderer, font, "M pour changer la précision: PERTURBATION", windowWidth - 10, windowHeight - 10 * verticalSpacing, ORIGIN_UP_RIGHT);
+                        break;
+                    case PRECISION_BLA:
+                        render_text(renderer, font, "M pour changer la précision:          BLA", windowWidth - 10, windowHeight - 10 * verticalSpacing, ORIGIN_UP_RIGHT);
+                        break;
+                    case PRECISION_DOUBLE_DOUBLE:
+                        render_text(renderer, font, "M pour changer la précision: DOUBLE-DOUBLE", windowWidth - 10, windowHeight - 10 * verticalSpacing, ORIGIN_UP_RIGHT);
+                        break;
+                    default:
+                        render_text(renderer, font, "M pour changer la précision:      NORMALE", windowWidth - 10, windowHeight - 10 * verticalSpacing, ORIGIN_UP_RIGHT);
+                }
+            }
+
             #ifdef __linux__
-                if (advancedMode) {
-                    render_text(renderer, font, "M pour toggle précision Normale/Haute:   HAUTE", windowWidth - 10, windowHeight - 10 * verticalSpacing, ORIGIN_UP_RIGHT);
+                if (seriesApproximation) {
+                    render_text(renderer, font, "A pour toggle l'approximation par séries:  ON", windowWidth - 10, windowHeight - 13 * verticalSpacing, ORIGIN_UP_RIGHT);
                 } else {
-                    render_text(renderer, font, "M pour toggle précision Normale/Haute: NORMALE", windowWidth - 10, windowHeight - 10 * verticalSpacing, ORIGIN_UP_RIGHT);
+                    render_text(renderer, font, "A pour toggle l'approximation par séries: OFF", windowWidth - 10, windowHeight - 13 * verticalSpacing, ORIGIN_UP_RIGHT);
+                }
+                if (nucleusReference) {
+                    render_text(renderer, font, "N pour toggle la référence sur un noyau:  ON", windowWidth - 10, windowHeight - 14 * verticalSpacing, ORIGIN_UP_RIGHT);
+                } else {
+                    render_text(renderer, font, "N pour toggle la référence sur un noyau: OFF", windowWidth - 10, windowHeight - 14 * verticalSpacing, ORIGIN_UP_RIGHT);
+                }
+                render_text(renderer, font, "G pour centrer sur le noyau le plus proche", windowWidth - 10, windowHeight - 15 * verticalSpacing, ORIGIN_UP_RIGHT);
+                if (pipelinedReference) {
+                    render_text(renderer, font, "P pour toggle les pixels pendant l'orbite:  ON", windowWidth - 10, windowHeight - 16 * verticalSpacing, ORIGIN_UP_RIGHT);
+                } else {
+                    render_text(renderer, font, "P pour toggle les pixels pendant l'orbite: OFF", windowWidth - 10, windowHeight - 16 * verticalSpacing, ORIGIN_UP_RIGHT);
                 }
             #endif
 
@@ -942,11 +1290,19 @@ int main(int argc, char *argv[]) {
             render_text(renderer, font, "H pour toggle l'interface", windowWidth - 10, windowHeight - 8 * verticalSpacing, ORIGIN_UP_RIGHT);
             render_text(renderer, font, "W: Zoom  X: OffsetX  C: OffsetY  I: Itération max", windowWidth - 10, windowHeight - 9 * verticalSpacing, ORIGIN_UP_RIGHT);
 
+            sprintf(displayBuffer, "S pour changer le mode de rendu: %s", render_mode_name(renderMode));
+            render_text(renderer, font, displayBuffer, windowWidth - 10, windowHeight - 11 * verticalSpacing, ORIGIN_UP_RIGHT);
+            if (verifyFills) {
+                render_text(renderer, font, "V pour toggle la vérification des remplissages:  ON", windowWidth - 10, windowHeight - 12 * verticalSpacing, ORIGIN_UP_RIGHT);
+            } else {
+                render_text(renderer, font, "V pour toggle la vérification des remplissages: OFF", windowWidth - 10, windowHeight - 12 * verticalSpacing, ORIGIN_UP_RIGHT);
+            }
+
             // Si on sélectionne une zone
             if (rightDragging) {
 
                 // Imprime la texture du Mandelbrot correctement placée par rapport au zoom et à l'offset
-                draw_mandelbrot_well_placed(renderer, fractalTexture, windowWidth, windowHeight, zoom, lastZoom, lastOffsetX, lastOffsetY, offsetX, offsetY);
+                draw_mandelbrot_well_placed(renderer, fractalTexture, windowWidth, windowHeight, &view, &lastView);
                 
                 // Dessine le rectangle blanc de sélection
                 SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
@@ -1055,7 +1411,39 @@ int main(int argc, char *argv[]) {
         SDL_Delay(10);
     }
 
+    // Arrête le calcul en cours avant de libérer l'orbite et la map d'itérations: l'orbite de référence et la
+    // correction des glitchs sont abandonnées et attendues d'abord, les workers peuvent encore suivre l'orbite
+    #ifdef __linux__
+        reference_orbit_cancel(&reference);
+        thread_pool_cancel(pool);
+        if (referenceThread) {
+            SDL_WaitThread(referenceThread, NULL);
+        }
+        if (glitchThread) {
+            SDL_WaitThread(glitchThread, NULL);
+        }
+        if (nucleusThread) {
+            SDL_WaitThread(nucleusThread, NULL);
+        }
+    #endif
+    thread_pool_destroy(pool);
+    #ifdef __linux__
+        reference_orbit_free(&reference);
+        nucleus_job_free(&nucleusJob);
+        mpfr_clear(task.centerX);
+        mpfr_clear(task.centerY);
+    #endif
+
+    view_clear(&view);
+    view_clear(&lastView);
+    view_clear(&lastViewSave);
+    for (int i = 0; i < MAX_HISTORY; i++) {
+        view_clear(&history[i]);
+    }
+
     free(task.iterationMap);
+    free(resumeX);
+    free(resumeY);
 
     // Ferme les polices d'écriture
     TTF_CloseFont(font);
@@ -1137,21 +1525,17 @@ void generate_palette_rainbow() {
 
 
 // Ajoute la vue actuelle a l'historique
-void push_view(double zoom, double offsetX, double offsetY) {
+void push_view(const FractalView *view) {
     if (historyIndex < MAX_HISTORY - 1) {
         historyIndex++;
-        history[historyIndex].zoom = zoom;
-        history[historyIndex].offsetX = offsetX;
-        history[historyIndex].offsetY = offsetY;
+        view_copy(&history[historyIndex], view);
     }
 }
 
 // Retire une vue de l'historique et la mettre dans le zoom et l'offset actuel
-bool pop_view(double *zoom, double *offsetX, double *offsetY) {
+bool pop_view(FractalView *view) {
     if (historyIndex >= 0) {
-        *zoom = history[historyIndex].zoom;
-        *offsetX = history[historyIndex].offsetX;
-        *offsetY = history[historyIndex].offsetY;
+        view_copy(view, &history[historyIndex]);
         historyIndex--;
         return true;
     }
@@ -1160,141 +1544,6 @@ bool pop_view(double *zoom, double *offsetX, double *offsetY) {
 
 
 
-// Calcule le nombre d'itérations de chaque pixels
-int calculate_iterations(void* arg) {
-    FractalTask* task = (FractalTask*)arg;
-
-    int w = task->width;
-    int h = task->height;
-    int total = w * h;
-    int done = 0;
-
-    *task->actual_max = 0;
-
-    *task->finished = false;
-    *task->progress = 0;
-
-    for (int py = 0; py < h; py++) {
-        for (int px = 0; px < w; px++) {
-            double x0 = (px - w / 2.0) / task->zoom + task->offsetX;
-            double y0 = (py - h / 2.0) / task->zoom + task->offsetY;
-
-            double x = 0.0, y = 0.0;
-            int iteration = 0;
-
-            while (x * x + y * y <= 4.0 && iteration < task->max_iteration) {
-                double xtemp = x * x - y * y + x0;
-                y = 2.0 * x * y + y0;
-                x = xtemp;
-                iteration++;
-            }
-
-            task->iterationMap[py * w + px] = iteration;
-            if (iteration > *task->actual_max)
-                *task->actual_max = iteration;
-
-            done++;
-        }
-        // Mettre à jour la progression une fois par ligne
-        *task->progress = (done * 100) / total;
-    }
-
-    *task->finished = true;
-    return 0;
-}
-
-
-// Calcule le nombre d'itérations de chaque pixels
-// Utilise une biliothèque permettant un zoom techniquement infini
-#ifdef __linux__
-    int calculate_iterations_high_precision(void* arg) {
-        FractalTask* task = (FractalTask*)arg;
-
-        int w = task->width;
-        int h = task->height;
-        int total = w * h;
-        int done = 0;
-
-        *task->actual_max = 0;
-        *task->finished = false;
-        *task->progress = 0;
-
-        mpfr_prec_t precision = 256;
-
-        // Variables MPFR
-        mpfr_t x0, y0, x, y, xtemp, xsqr, ysqr, sum;
-        mpfr_t two, four, offsetX, offsetY, inv_zoom, px_shifted, py_shifted;
-
-        mpfr_inits2(precision, x0, y0, x, y, xtemp, xsqr, ysqr, sum, two, four,
-                    offsetX, offsetY, inv_zoom, px_shifted, py_shifted, (mpfr_ptr) 0);
-
-        mpfr_set_d(two, 2.0, MPFR_RNDN);
-        mpfr_set_d(four, 4.0, MPFR_RNDN);
-        mpfr_set_d(offsetX, task->offsetX, MPFR_RNDN);
-        mpfr_set_d(offsetY, task->offsetY, MPFR_RNDN);
-
-        // Inverser zoom pour éviter de diviser à chaque pixel
-        mpfr_set_d(inv_zoom, 1.0 / task->zoom, MPFR_RNDN);
-
-        double half_w = w / 2.0;
-        double half_h = h / 2.0;
-
-        for (int py = 0; py < h; py++) {
-            double y_base = py - half_h;
-            mpfr_set_d(py_shifted, y_base, MPFR_RNDN);
-            mpfr_mul(y0, py_shifted, inv_zoom, MPFR_RNDN);
-            mpfr_add(y0, y0, offsetY, MPFR_RNDN);
-
-            for (int px = 0; px < w; px++) {
-                double x_base = px - half_w;
-                mpfr_set_d(px_shifted, x_base, MPFR_RNDN);
-                mpfr_mul(x0, px_shifted, inv_zoom, MPFR_RNDN);
-                mpfr_add(x0, x0, offsetX, MPFR_RNDN);
-
-                mpfr_set_d(x, 0.0, MPFR_RNDN);
-                mpfr_set_d(y, 0.0, MPFR_RNDN);
-
-                int iteration = 0;
-
-                while (iteration < task->max_iteration) {
-                    mpfr_sqr(xsqr, x, MPFR_RNDN);    // xsqr = x^2
-                    mpfr_sqr(ysqr, y, MPFR_RNDN);    // ysqr = y^2
-                    mpfr_add(sum, xsqr, ysqr, MPFR_RNDN);
-
-                    if (mpfr_cmp(sum, four) > 0) break;
-
-                    mpfr_sub(xtemp, xsqr, ysqr, MPFR_RNDN);   // xtemp = x^2 - y^2
-                    mpfr_add(xtemp, xtemp, x0, MPFR_RNDN);    // xtemp += x0
-
-                    mpfr_mul(y, x, y, MPFR_RNDN);
-                    mpfr_mul(y, y, two, MPFR_RNDN);
-                    mpfr_add(y, y, y0, MPFR_RNDN);
-
-                    mpfr_set(x, xtemp, MPFR_RNDN);
-
-                    iteration++;
-                }
-
-                task->iterationMap[py * w + px] = iteration;
-                if (iteration > *task->actual_max)
-                    *task->actual_max = iteration;
-
-                done++;
-            }
-
-            *task->progress = (done * 100) / total;
-        }
-
-        mpfr_clears(x0, y0, x, y, xtemp, xsqr, ysqr, sum,
-                    two, four, offsetX, offsetY, inv_zoom,
-                    px_shifted, py_shifted, (mpfr_ptr) 0);
-
-        *task->finished = true;
-        return 0;
-    }
-#endif
-
-
 // Fait le rendu en couleurs des itérations sur la cible SDL
 void render_iterations(SDL_Renderer *renderer, int *iterationMap, int w, int h, SDL_Color *palette, int max_iteration, int actual_max, bool antialiasing) {
 
@@ -1350,32 +1599,28 @@ double clamp_double(double val, double min, double max) {
 }
 
 
-// transforme les coordonnée de l'écran en coordonnée de fractale
-void screen_to_fractal(int x, int y, double zoom, double offsetX, double offsetY, int width, int height, double *fx, double *fy) {
-    *fx = (x - width / 2) / zoom + offsetX;
-    *fy = (y - height / 2) / zoom + offsetY;
-}
 
                           
 // Appelle toute les fonctions nécéssaire a l'affichage de la texture proportionnel au zoom et au coordonnées
-void draw_mandelbrot_well_placed(SDL_Renderer *renderer, SDL_Texture *texture, int windowWidth, int windowHeight, double zoom, double lastZoom, 
-                           double lastOffsetX, double lastOffsetY, double offsetX, double offsetY) {
+void draw_mandelbrot_well_placed(SDL_Renderer *renderer, SDL_Texture *texture, int windowWidth, int windowHeight,
+                                 const FractalView *view, const FractalView *lastView) {
 
     // Récupère la taille de la texture
     int textureWidth, textureHeight;
     SDL_QueryTexture(texture, NULL, NULL, &textureWidth, &textureHeight);
 
-    // Calcule les coins dans l'ancien espace fractal (avant zoom)
-    double fx1, fy1, fx2, fy2;
-    screen_to_fractal(0, 0, zoom, offsetX, offsetY, windowWidth, windowHeight, &fx1, &fy1);
-    screen_to_fractal(windowWidth, windowHeight, zoom, offsetX, offsetY, windowWidth, windowHeight, &fx2, &fy2);
-    
+    // Rapport entre le nouveau et l'ancien zoom, raisonnable même quand les zooms ne tiennent pas en double
+    double zoomRatio = fe_to_double(fe_div(view->zoom, lastView->zoom));
+
+    // Position du centre actuel dans l'ancienne texture, relativement à son centre
+    double shiftX, shiftY;
+    view_offset_pixels(lastView, view, &shiftX, &shiftY);
     
-    // Reprojette les coins (fx1, fy1) et (fx2, fy2) en pixels dans l’ancienne texture
-    double sx1 = (fx1 - lastOffsetX) * lastZoom + textureWidth / 2.0;
-    double sy1 = (fy1 - lastOffsetY) * lastZoom + textureHeight / 2.0;
-    double sx2 = (fx2 - lastOffsetX) * lastZoom + textureWidth / 2.0;
-    double sy2 = (fy2 - lastOffsetY) * lastZoom + textureHeight / 2.0;
+    // Reprojette les coins de l'écran en pixels dans l’ancienne texture
+    double sx1 = (0 - windowWidth / 2) / zoomRatio + shiftX + textureWidth / 2.0;
+    double sy1 = (0 - windowHeight / 2) / zoomRatio + shiftY + textureHeight / 2.0;
+    double sx2 = (windowWidth - windowWidth / 2) / zoomRatio + shiftX + textureWidth / 2.0;
+    double sy2 = (windowHeight - windowHeight / 2) / zoomRatio + shiftY + textureHeight / 2.0;
 
 
     // On limite les valeurs des positions maximales
@@ -1398,11 +1643,11 @@ void draw_mandelbrot_well_placed(SDL_Renderer *renderer, SDL_Texture *texture, i
     SDL_Rect destRect;
 
     // Destination : fenêtre de rendu, ajustée au nouveau zoom
-    destRect.w = (int)(textureWidth * (zoom / lastZoom));
-    destRect.h = (int)(textureHeight * (zoom / lastZoom));
+    destRect.w = (int)(textureWidth * zoomRatio);
+    destRect.h = (int)(textureHeight * zoomRatio);
 
-    destRect.x = (windowWidth - destRect.w) / 2 + (int)((lastOffsetX - offsetX) * zoom);
-    destRect.y = (windowHeight - destRect.h) / 2 + (int)((lastOffsetY - offsetY) * zoom);
+    destRect.x = (windowWidth - destRect.w) / 2 + (int)(-shiftX * zoomRatio);
+    destRect.y = (windowHeight - destRect.h) / 2 + (int)(-shiftY * zoomRatio);
     
 
 
@@ -1426,18 +1671,18 @@ void draw_mandelbrot_well_placed(SDL_Renderer *renderer, SDL_Texture *texture, i
     
     // Clamp le destRect à l’intérieur de la fenêtre
     if (destRect.x < 0) {
-        destRect.w += destRect.x - offsetIntDoubleDestW * (zoom / lastZoom);
+        destRect.w += destRect.x - offsetIntDoubleDestW * zoomRatio;
         destRect.x = 0;
     }
     if (destRect.y < 0) {
-        destRect.h += destRect.y - offsetIntDoubleDestH * (zoom / lastZoom);
+        destRect.h += destRect.y - offsetIntDoubleDestH * zoomRatio;
         destRect.y = 0;
     }
     if (destRect.x + destRect.w > windowWidth) {
-        destRect.w = windowWidth - destRect.x + offsetIntDoubleDestW * (zoom / lastZoom);
+        destRect.w = windowWidth - destRect.x + offsetIntDoubleDestW * zoomRatio;
     }
     if (destRect.y + destRect.h > windowHeight) {
-        destRect.h = windowHeight - destRect.y + offsetIntDoubleDestH * (zoom / lastZoom);
+        destRect.h = windowHeight - destRect.y + offsetIntDoubleDestH * zoomRatio;
     }
     
 
@@ -1445,16 +1690,16 @@ void draw_mandelbrot_well_placed(SDL_Renderer *renderer, SDL_Texture *texture, i
     double fractalShiftX = (sx1 < sx2 ? sx1 : sx2) - (double)srcRect.x;
     double fractalShiftY = (sy1 < sy2 ? sy1 : sy2) - (double)srcRect.y;
 
-    double subPixelOffsetX = fractalShiftX * (zoom / lastZoom);
-    double subPixelOffsetY = fractalShiftY * (zoom / lastZoom);
+    double subPixelOffsetX = fractalShiftX * zoomRatio;
+    double subPixelOffsetY = fractalShiftY * zoomRatio;
 
     // Ajuste la destination
     destRect.x -= (int)round(subPixelOffsetX);
     destRect.y -= (int)round(subPixelOffsetY);
 
     // Ajuste la source (pour rester aligné avec le zoom)
-    srcRect.x += (int)floor(subPixelOffsetX / (zoom / lastZoom));
-    srcRect.y += (int)floor(subPixelOffsetY / (zoom / lastZoom));
+    srcRect.x += (int)floor(subPixelOffsetX / zoomRatio);
+    srcRect.y += (int)floor(subPixelOffsetY / zoomRatio);
     
     
     // Efface l'écran en noir
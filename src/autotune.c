@@ -0,0 +1,198 @@
+
+/*
+
+    Réglage automatique du calcul pour la machine
+
+    Au premier lancement (ou avec --autotune), chaque variante de noyau supportée
+    est mesurée sur une petite image, puis la taille des tuiles et enfin le nombre
+    de threads, en gardant à chaque étape la combinaison la plus rapide. Le résultat
+    est écrit dans un fichier local avec la signature du processeur, pour que les
+    lancements suivants n'aient pas à refaire les mesures.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "autotune.h"
+#include "dispatch.h"
+#include "thread_pool.h"
+
+// Taille de l'image de mesure, assez petite pour que le réglage dure environ une seconde
+#define TUNE_WIDTH 480
+#define TUNE_HEIGHT 320
+
+// Nombre de mesures par combinaison, on garde la meilleure
+#define TUNE_RUNS 2
+
+
+// Une vue dominée par l'intérieur de l'ensemble et une vue de bord
+static const struct {
+    double zoom, offsetX, offsetY;
+    int max_iteration;
+} tuneViews[] = {
+    { 80.0,  -0.5,          0.0,          200  },
+    { 8e4,   -0.7436447860, 0.1318252536, 1000 },
+};
+
+static const int tuneTileSizes[] = { 16, 32, 64, 128 };
+
+
+// Temps total pour calculer les vues de mesure, en millisecondes
+static double measure(int threadCount, int tileSize, SpanKernel kernel, FractalTask *task) {
+    ThreadPool *pool = thread_pool_create(threadCount, tileSize);
+    double total = 0.0;
+
+    for (size_t v = 0; v < sizeof(tuneViews) / sizeof(tuneViews[0]); v++) {
+        task->zoom = tuneViews[v].zoom;
+        task->offsetX = tuneViews[v].offsetX;
+        task->offsetY = tuneViews[v].offsetY;
+        task->max_iteration = tuneViews[v].max_iteration;
+
+        double best = 0.0;
+        for (int run = 0; run < TUNE_RUNS; run++) {
+            Uint64 start = SDL_GetPerformanceCounter();
+            thread_pool_launch(pool, task, kernel);
+            thread_pool_wait(pool);
+            double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+            if (run == 0 || ms < best)
+                best = ms;
+        }
+        total += best;
+    }
+
+    thread_pool_destroy(pool);
+    return total;
+}
+
+
+void default_tune_config(TuneConfig *config) {
+    snprintf(config->kernel, sizeof(config->kernel), "%s", best_double_kernel()->name);
+    config->tileSize = DEFAULT_TILE_SIZE;
+    config->threadCount = SDL_GetCPUCount();
+}
+
+bool load_tune_config(const char *path, TuneConfig *config) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    char signature[128];
+    cpu_signature(signature, sizeof(signature));
+
+    TuneConfig loaded = {0};
+    bool sameMachine = false;
+    char line[256];
+
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if (strncmp(line, "cpu=", 4) == 0) {
+            sameMachine = strcmp(line + 4, signature) == 0;
+        } else if (strncmp(line, "kernel=", 7) == 0) {
+            size_t length = strlen(line + 7);
+            if (length < sizeof(loaded.kernel))
+                memcpy(loaded.kernel, line + 7, length + 1);
+        } else if (strncmp(line, "tile=", 5) == 0) {
+            loaded.tileSize = atoi(line + 5);
+        } else if (strncmp(line, "threads=", 8) == 0) {
+            loaded.threadCount = atoi(line + 8);
+        }
+    }
+    fclose(file);
+
+    // Réglage d'une autre machine ou fichier abimé: on le refait
+    if (!sameMachine || !find_double_kernel(loaded.kernel)
+        || loaded.tileSize < 8 || loaded.tileSize > 1024
+        || loaded.threadCount < 1 || loaded.threadCount > 1024) {
+        return false;
+    }
+
+    *config = loaded;
+    return true;
+}
+
+bool save_tune_config(const char *path, const TuneConfig *config) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        SDL_Log("Erreur écriture du réglage : %s", path);
+        return false;
+    }
+
+    char signature[128];
+    cpu_signature(signature, sizeof(signature));
+
+    fprintf(file, "# Réglage automatique du calcul, supprimer ce fichier pour refaire les mesures\n");
+    fprintf(file, "cpu=%s\n", signature);
+    fprintf(file, "kernel=%s\n", config->kernel);
+    fprintf(file, "tile=%d\n", config->tileSize);
+    fprintf(file, "threads=%d\n", config->threadCount);
+
+    fclose(file);
+    return true;
+}
+
+void autotune(TuneConfig *config) {
+    default_tune_config(config);
+
+    int actualMax = 0, progress = 0;
+    bool finished = false;
+    FractalTask task = {0};
+    task.iterationMap = malloc(TUNE_WIDTH * TUNE_HEIGHT * sizeof(int));
+    task.actual_max = &actualMax;
+    task.progress = &progress;
+    task.finished = &finished;
+    task.width = TUNE_WIDTH;
+    task.height = TUNE_HEIGHT;
+
+    // 1. Le noyau, avec la taille de tuiles par défaut et tous les coeurs
+    double bestTime = -1.0;
+    for (int i = 0; i < double_kernel_variant_count; i++) {
+        const KernelVariant *variant = &double_kernel_variants[i];
+        if (!kernel_variant_supported(variant))
+            continue;
+
+        double time = measure(config->threadCount, config->tileSize, variant->kernel, &task);
+        if (bestTime < 0.0 || time < bestTime) {
+            bestTime = time;
+            snprintf(config->kernel, sizeof(config->kernel), "%s", variant->name);
+        }
+    }
+    SpanKernel kernel = find_double_kernel(config->kernel)->kernel;
+
+    // 2. La taille des tuiles avec ce noyau
+    bestTime = -1.0;
+    int bestTileSize = config->tileSize;
+    for (size_t i = 0; i < sizeof(tuneTileSizes) / sizeof(tuneTileSizes[0]); i++) {
+        double time = measure(config->threadCount, tuneTileSizes[i], kernel, &task);
+        if (bestTime < 0.0 || time < bestTime) {
+            bestTime = time;
+            bestTileSize = tuneTileSizes[i];
+        }
+    }
+    config->tileSize = bestTileSize;
+
+    // 3. Le nombre de threads, utile quand les coeurs logiques partagent leurs unités de calcul
+    int cpuCount = SDL_GetCPUCount();
+    int threadCandidates[3] = { cpuCount, cpuCount * 3 / 4, cpuCount / 2 };
+    bestTime = -1.0;
+    for (int i = 0; i < 3; i++) {
+        if (threadCandidates[i] < 1 || (i > 0 && threadCandidates[i] == threadCandidates[i - 1]))
+            continue;
+
+        double time = measure(threadCandidates[i], config->tileSize, kernel, &task);
+        if (bestTime < 0.0 || time < bestTime) {
+            bestTime = time;
+            config->threadCount = threadCandidates[i];
+        }
+    }
+
+    free(task.iterationMap);
+
+    SDL_Log("Réglage automatique : noyau %s, tuiles de %d, %d threads", config->kernel, config->tileSize, config->threadCount);
+}
@@ -0,0 +1,245 @@
+
+/*
+
+    Construction de la table BLA
+
+    Niveau 0: une itération à partir de m, d -> 2 Z_m d + dc en négligeant d²,
+    juste tant que |d| < epsilon |2 Z_m|.
+    Niveau l: deux blocs consécutifs x puis y du niveau l - 1 se composent en
+        A = Ay Ax
+        B = Ay Bx + By
+        r = min(rx, (ry - |Bx| |dc|max) / |Ax|)
+    Chaque niveau ne dépend que du précédent, ses blocs sont répartis entre les threads.
+    Les threads sont créés une fois pour toute la table et s'attendent entre deux
+    niveaux; les derniers niveaux, trop petits, sont finis par le thread appelant.
+
+    Aux zooms où |dc| passe sous ce que le double représente, A et B dépassent
+    aussi sa plage: la table étendue fait les mêmes calculs en floatexp.
+
+*/
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+
+#include "bla.h"
+#include "perturbation.h"
+
+// Erreur relative tolérée en négligeant d² devant 2 Z d
+#define BLA_EPSILON 0x1p-50
+
+// En dessous, un niveau est construit par le seul thread appelant
+#define BLA_PARALLEL_MIN 16384
+
+
+#ifdef __linux__
+
+    // Construction partagée entre les threads, qui s'attendent à la fin de chaque niveau
+    typedef struct {
+        BlaTable *table;
+        const ReferenceOrbit *orbit;
+        int threadCount;
+
+        SDL_mutex *mutex;
+        SDL_cond *levelDone;
+        int arrived;        // Threads qui ont fini le niveau en cours
+        int generation;     // Niveaux finis par tous les threads
+    } BlaBuild;
+
+    // Un thread de la construction, le thread appelant a l'index 0
+    typedef struct {
+        BlaBuild *build;
+        int index;
+    } BlaJob;
+
+    static void build_level_range(BlaTable *table, const ReferenceOrbit *orbit, int level, int begin, int end) {
+        double dcMax = fe_to_double(table->dcMax);
+        BlaStep *steps = table->steps + table->levelOffset[level];
+
+        if (level == 0) {
+            for (int j = begin; j < end; j++) {
+                double ar = 2.0 * orbit->zr[j + 1];
+                double ai = 2.0 * orbit->zi[j + 1];
+                steps[j].A[0] = ar;
+                steps[j].A[1] = ai;
+                steps[j].B[0] = 1.0;
+                steps[j].B[1] = 0.0;
+                steps[j].radius = BLA_EPSILON * hypot(ar, ai);
+            }
+            return;
+        }
+
+        const BlaStep *previous = table->steps + table->levelOffset[level - 1];
+        for (int j = begin; j < end; j++) {
+            const BlaStep *x = &previous[2 * j];
+            const BlaStep *y = &previous[2 * j + 1];
+
+            BlaStep *z = &steps[j];
+            z->A[0] = y->A[0] * x->A[0] - y->A[1] * x->A[1];
+            z->A[1] = y->A[0] * x->A[1] + y->A[1] * x->A[0];
+            z->B[0] = y->A[0] * x->B[0] - y->A[1] * x->B[1] + y->B[0];
+            z->B[1] = y->A[0] * x->B[1] + y->A[1] * x->B[0] + y->B[1];
+
+            double ax = hypot(x->A[0], x->A[1]);
+            double bx = hypot(x->B[0], x->B[1]);
+            double ry = (ax > 0.0) ? (y->radius - bx * dcMax) / ax : 0.0;
+            z->radius = smallest(x->radius, largest(0.0, ry));
+        }
+    }
+
+    // |a| d'un complexe en floatexp
+    static inline floatexp fe_complex_abs(const floatexp *a) {
+        return fe_sqrt(fe_add(fe_mul(a[0], a[0]), fe_mul(a[1], a[1])));
+    }
+
+    static void build_level_range_exp(BlaTable *table, const ReferenceOrbit *orbit, int level, int begin, int end) {
+        BlaStepExp *steps = table->stepsExp + table->levelOffset[level];
+
+        if (level == 0) {
+            for (int j = begin; j < end; j++) {
+                double ar = 2.0 * orbit->zr[j + 1];
+                double ai = 2.0 * orbit->zi[j + 1];
+                steps[j].A[0] = fe_from_double(ar);
+                steps[j].A[1] = fe_from_double(ai);
+                steps[j].B[0] = fe_from_double(1.0);
+                steps[j].B[1] = fe_from_double(0.0);
+                steps[j].radius = fe_from_double(BLA_EPSILON * hypot(ar, ai));
+            }
+            return;
+        }
+
+        const BlaStepExp *previous = table->stepsExp + table->levelOffset[level - 1];
+        for (int j = begin; j < end; j++) {
+            const BlaStepExp *x = &previous[2 * j];
+            const BlaStepExp *y = &previous[2 * j + 1];
+
+            BlaStepExp *z = &steps[j];
+            z->A[0] = fe_sub(fe_mul(y->A[0], x->A[0]), fe_mul(y->A[1], x->A[1]));
+            z->A[1] = fe_add(fe_mul(y->A[0], x->A[1]), fe_mul(y->A[1], x->A[0]));
+            z->B[0] = fe_add(fe_sub(fe_mul(y->A[0], x->B[0]), fe_mul(y->A[1], x->B[1])), y->B[0]);
+            z->B[1] = fe_add(fe_add(fe_mul(y->A[0], x->B[1]), fe_mul(y->A[1], x->B[0])), y->B[1]);
+
+            floatexp ax = fe_complex_abs(x->A);
+            floatexp bx = fe_complex_abs(x->B);
+            floatexp ry = fe_from_double(0.0);
+            if (ax.mantissa > 0.0)
+                ry = fe_div(fe_sub(y->radius, fe_mul(bx, table->dcMax)), ax);
+            if (ry.mantissa < 0.0)
+                ry = fe_from_double(0.0);
+            z->radius = fe_less(ry, x->radius) ? ry : x->radius;
+        }
+    }
+
+    static void build_level(BlaTable *table, const ReferenceOrbit *orbit, int level, int begin, int end) {
+        if (table->extended)
+            build_level_range_exp(table, orbit, level, begin, end);
+        else
+            build_level_range(table, orbit, level, begin, end);
+    }
+
+    // Attend que tous les threads aient fini le niveau en cours
+    static void level_barrier(BlaBuild *build) {
+        SDL_LockMutex(build->mutex);
+        int generation = build->generation;
+        if (++build->arrived == build->threadCount) {
+            build->arrived = 0;
+            build->generation++;
+            SDL_CondBroadcast(build->levelDone);
+        } else {
+            while (generation == build->generation)
+                SDL_CondWait(build->levelDone, build->mutex);
+        }
+        SDL_UnlockMutex(build->mutex);
+    }
+
+    // Sa part de chaque niveau assez grand pour être partagé, puis les suivants pour le thread appelant seulement
+    static int build_level_job(void *arg) {
+        BlaJob *job = (BlaJob*)arg;
+        BlaBuild *build = job->build;
+        BlaTable *table = build->table;
+
+        int level = 0;
+        for (; level < table->levels && table->levelCount[level] >= BLA_PARALLEL_MIN; level++) {
+            int levelCount = table->levelCount[level];
+            int begin = (int)((int64_t)levelCount * job->index / build->threadCount);
+            int end = (int)((int64_t)levelCount * (job->index + 1) / build->threadCount);
+            build_level(table, build->orbit, level, begin, end);
+            level_barrier(build);
+        }
+
+        if (job->index == 0) {
+            for (; level < table->levels; level++)
+                build_level(table, build->orbit, level, 0, table->levelCount[level]);
+        }
+        return 0;
+    }
+
+    void bla_table_free(BlaTable *table) {
+        free(table->steps);
+        free(table->stepsExp);
+        table->steps = NULL;
+        table->stepsExp = NULL;
+        table->extended = false;
+        table->levels = 0;
+        table->dcMax = fe_from_double(0.0);
+    }
+
+    void bla_table_build(BlaTable *table, const ReferenceOrbit *orbit, floatexp dcMax, int threadCount) {
+        bla_table_free(table);
+
+        // Un bloc de niveau 0 par itération m de 1 à length - 2, m + 1 doit rester dans l'orbite
+        int count = orbit->length - 2;
+        if (count < 1)
+            return;
+
+        int total = 0;
+        while (count > 0 && table->levels < 31) {
+            table->levelOffset[table->levels] = total;
+            table->levelCount[table->levels] = count;
+            total += count;
+            table->levels++;
+            count /= 2;
+        }
+
+        table->extended = dcMax.exponent < FLOATEXP_DOUBLE_MIN_EXP;
+        if (table->extended)
+            table->stepsExp = malloc((size_t)total * sizeof(BlaStepExp));
+        else
+            table->steps = malloc((size_t)total * sizeof(BlaStep));
+        table->dcMax = dcMax;
+
+        // Threads seulement si au moins le niveau 0 est à partager
+        if (threadCount < 1 || table->levelCount[0] < BLA_PARALLEL_MIN)
+            threadCount = 1;
+
+        BlaBuild build;
+        build.table = table;
+        build.orbit = orbit;
+        build.threadCount = threadCount;
+        build.mutex = SDL_CreateMutex();
+        build.levelDone = SDL_CreateCond();
+        build.arrived = 0;
+        build.generation = 0;
+
+        SDL_Thread **threads = malloc(threadCount * sizeof(SDL_Thread*));
+        BlaJob *jobs = malloc(threadCount * sizeof(BlaJob));
+        for (int t = 0; t < threadCount; t++) {
+            jobs[t].build = &build;
+            jobs[t].index = t;
+        }
+        for (int t = 1; t < threadCount; t++)
+            threads[t] = SDL_CreateThread(build_level_job, "BLA", &jobs[t]);
+
+        build_level_job(&jobs[0]);
+
+        for (int t = 1; t < threadCount; t++)
+            SDL_WaitThread(threads[t], NULL);
+
+        SDL_DestroyCond(build.levelDone);
+        SDL_DestroyMutex(build.mutex);
+        free(jobs);
+        free(threads);
+    }
+
+#endif
@@ -0,0 +1,124 @@
+
+/*
+
+    Choix à l'exécution du noyau adapté au processeur
+
+    Le même exécutable tourne sur des machines qui vont du simple SSE2 à
+    l'AVX-512. Toutes les variantes sont compilées, chacune avec ses propres
+    instructions, et on ne garde que celles que CPUID annonce comme supportées.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <cpuid.h>
+#endif
+
+#include "dispatch.h"
+#include "kernels.h"
+
+
+const KernelVariant double_kernel_variants[] = {
+    #if defined(__x86_64__) || defined(__i386__)
+        { "avx512",         calculate_iterations_avx512,        SDL_HasAVX512F },
+        { "avx512-continu", calculate_iterations_stream_avx512, SDL_HasAVX512F },
+        { "avx2",           calculate_iterations_avx2,          SDL_HasAVX2 },
+        { "avx2-continu",   calculate_iterations_stream_avx2,   SDL_HasAVX2, true },
+        { "sse2",           calculate_iterations_sse2,          SDL_HasSSE2 },
+    #endif
+    { "scalaire",           calculate_iterations,               NULL, true },
+};
+
+const int double_kernel_variant_count = sizeof(double_kernel_variants) / sizeof(double_kernel_variants[0]);
+
+// SDL ne teste pas le FMA, que les noyaux double-double AVX2 utilisent en plus
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    static SDL_bool has_avx2_fma(void) {
+        return (SDL_HasAVX2() && __builtin_cpu_supports("fma")) ? SDL_TRUE : SDL_FALSE;
+    }
+#endif
+
+const KernelVariant double_double_kernel_variants[] = {
+    #if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        { "dd-avx512",      calculate_iterations_double_double_avx512, SDL_HasAVX512F },
+        { "dd-avx2",        calculate_iterations_double_double_avx2,   has_avx2_fma },
+    #endif
+    { "dd-scalaire",        calculate_iterations_double_double,        NULL },
+};
+
+const int double_double_kernel_variant_count = sizeof(double_double_kernel_variants) / sizeof(double_double_kernel_variants[0]);
+
+
+bool kernel_variant_supported(const KernelVariant *variant) {
+    return variant->supported == NULL || variant->supported() == SDL_TRUE;
+}
+
+const KernelVariant *find_double_kernel(const char *name) {
+    for (int i = 0; i < double_kernel_variant_count; i++) {
+        if (strcmp(double_kernel_variants[i].name, name) == 0) {
+            return kernel_variant_supported(&double_kernel_variants[i]) ? &double_kernel_variants[i] : NULL;
+        }
+    }
+    return NULL;
+}
+
+const KernelVariant *best_double_kernel(void) {
+    for (int i = 0; i < double_kernel_variant_count; i++) {
+        if (kernel_variant_supported(&double_kernel_variants[i])) {
+            return &double_kernel_variants[i];
+        }
+    }
+    return &double_kernel_variants[double_kernel_variant_count - 1];
+}
+
+const KernelVariant *resumable_double_kernel(const KernelVariant *variant) {
+    if (variant->resumable)
+        return variant;
+
+    for (int i = 0; i < double_kernel_variant_count; i++) {
+        if (double_kernel_variants[i].resumable && kernel_variant_supported(&double_kernel_variants[i])) {
+            return &double_kernel_variants[i];
+        }
+    }
+    return &double_kernel_variants[double_kernel_variant_count - 1];
+}
+
+const KernelVariant *best_double_double_kernel(void) {
+    for (int i = 0; i < double_double_kernel_variant_count; i++) {
+        if (kernel_variant_supported(&double_double_kernel_variants[i])) {
+            return &double_double_kernel_variants[i];
+        }
+    }
+    return &double_double_kernel_variants[double_double_kernel_variant_count - 1];
+}
+
+void cpu_signature(char *buffer, size_t size) {
+    char brand[49] = "inconnu";
+
+    // Nom commercial du processeur, feuilles CPUID étendues 0x80000002 à 0x80000004
+    #if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        unsigned int regs[12];
+        if (__get_cpuid_max(0x80000000, NULL) >= 0x80000004) {
+            for (unsigned int i = 0; i < 3; i++) {
+                __get_cpuid(0x80000002 + i, &regs[4 * i], &regs[4 * i + 1], &regs[4 * i + 2], &regs[4 * i + 3]);
+            }
+            memcpy(brand, regs, sizeof(regs));
+            brand[48] = '\0';
+        }
+    #endif
+
+    // Retire les espaces de début que certains processeurs mettent dans leur nom
+    const char *trimmed = brand;
+    while (*trimmed == ' ') {
+        trimmed++;
+    }
+
+    snprintf(buffer, size, "%s/%d/%s%s%s", trimmed, SDL_GetCPUCount(),
+             SDL_HasSSE2() ? "sse2" : "",
+             SDL_HasAVX2() ? "+avx2" : "",
+             SDL_HasAVX512F() ? "+avx512f" : "");
+}
@@ -0,0 +1,298 @@
+
+/*
+
+    Noyaux de calcul des itérations du Mandelbrot
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+
+// Pour les calculs de haute précisions
+// Seulement pour la version linux
+#ifdef __linux__
+    #include <mpfr.h>
+    #include <gmp.h>
+#endif
+
+#include "kernels.h"
+#include "interior.h"
+
+
+// Calcule le nombre d'itérations de chaque pixel d'une portion de ligne
+void calculate_iterations(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) {
+    int w = task->width;
+    int h = task->height;
+
+    double y0 = (py - h / 2.0) / task->zoom + task->offsetY;
+    int *row = task->iterationMap + py * w;
+
+    // La périodicité n'est vérifiée que si le pixel précédent du worker n'a pas pu s'échapper,
+    // à l'extérieur la comparaison coûterait plus qu'elle ne fait gagner
+    bool checkPeriodicity = ctx->checkPeriodicity;
+
+    // Etat gardé des pixels arrêtés au maximum, pour une reprise avec un maximum plus grand
+    double *keptX = task->resumeX ? task->resumeX + py * w : NULL;
+    double *keptY = task->resumeY ? task->resumeY + py * w : NULL;
+
+    for (int px = xStart; px < xEnd; px++) {
+        double x = 0.0, y = 0.0;
+        int iteration = 0;
+
+        // Reprise: seuls les pixels arrêtés à l'ancien maximum continuent, depuis leur état
+        if (task->resumeFrom > 0 && !resume_pixel(task, ctx, py * w + px, &x, &y, &iteration))
+            continue;
+
+        double x0 = (px - w / 2.0) / task->zoom + task->offsetX;
+
+        if (iteration == 0 && in_main_cardioid_or_bulb(x0, y0)) {
+            row[px] = task->max_iteration;
+            checkPeriodicity = true;
+            if (keptX)
+                keptX[px] = keptY[px] = NAN;
+            continue;
+        }
+
+        // L'état repris sert de premier point de comparaison
+        double checkX = x, checkY = y;
+
+        while (x * x + y * y <= 4.0 && iteration < task->max_iteration) {
+            double xtemp = x * x - y * y + x0;
+            y = 2.0 * x * y + y0;
+            x = xtemp;
+            iteration++;
+
+            if (checkPeriodicity) {
+                // L'orbite est revenue sur un point déjà visité: elle ne s'échappera jamais
+                if (fabs(x - checkX) < PERIODICITY_TOLERANCE && fabs(y - checkY) < PERIODICITY_TOLERANCE) {
+                    ctx->iterationsSaved += task->max_iteration - iteration;
+                    iteration = task->max_iteration;
+                    x = y = NAN;
+                    break;
+                }
+
+                if (periodicity_checkpoint(iteration)) {
+                    checkX = x;
+                    checkY = y;
+                }
+            }
+        }
+
+        row[px] = iteration;
+        checkPeriodicity = (iteration == task->max_iteration);
+
+        if (keptX && checkPeriodicity) {
+            keptX[px] = x;
+            keptY[px] = y;
+        }
+    }
+
+    ctx->checkPeriodicity = checkPeriodicity;
+}
+
+
+int pixel_precision_bits(const FractalTask *task) {
+    // Plus grande valeur manipulée: |z| jusqu'à 2, ou |c| au coin le plus éloigné de l'image
+    double halfDiagonal = hypot(task->width, task->height) / 2.0;
+    floatexp magnitude = fe_add(fe_from_double(hypot(task->offsetX, task->offsetY)), fe_mul_d(task->pixelSize, halfDiagonal));
+    if (fe_less(magnitude, fe_from_double(2.0)))
+        magnitude = fe_from_double(2.0);
+
+    // Bits entre cette valeur et la taille d'un pixel
+    int64_t bits = (int64_t)magnitude.exponent + 1 - task->pixelSize.exponent;
+    return (int)smallest(bits, (int64_t)INT32_MAX);
+}
+
+// Même vérification que double_double_pixels_distinct, avec les coordonnées de calculate_iterations
+static bool double_pixels_distinct(const FractalTask *task) {
+    double pixel = 1.0 / task->zoom;
+    double tolerance = ldexp(pixel, -PRECISION_TIER_GUARD_BITS);
+
+    for (int px = 1; px < task->width; px++) {
+        double step = ((px - task->width / 2.0) / task->zoom + task->offsetX) - ((px - 1 - task->width / 2.0) / task->zoom + task->offsetX);
+        if (!(fabs(step - pixel) <= tolerance))
+            return false;
+    }
+    for (int py = 1; py < task->height; py++) {
+        double step = ((py - task->height / 2.0) / task->zoom + task->offsetY) - ((py - 1 - task->height / 2.0) / task->zoom + task->offsetY);
+        if (!(fabs(step - pixel) <= tolerance))
+            return false;
+    }
+    return true;
+}
+
+PrecisionTier cheapest_precision_tier(const FractalTask *task) {
+    // Au-delà de la mantisse d'un palier, des pixels voisins tombent sur la même coordonnée
+    // et l'image se découpe en blocs: l'estimation écarte d'abord les paliers trop courts
+    int bits = pixel_precision_bits(task);
+    if (bits <= 53 && double_pixels_distinct(task))
+        return TIER_DOUBLE;
+
+    #ifdef __linux__
+        if (bits <= 106 && double_double_pixels_distinct(task))
+            return TIER_DOUBLE_DOUBLE;
+        return TIER_HIGH;
+    #else
+        return TIER_DOUBLE_DOUBLE;
+    #endif
+}
+
+
+// Calcule le nombre d'itérations de chaque pixels
+// Utilise une biliothèque permettant un zoom techniquement infini
+#ifdef __linux__
+
+    // Même test que in_main_cardioid_or_bulb, fait en haute précision avec les variables de travail fournies
+    static bool in_main_cardioid_or_bulb_mpfr(mpfr_t x, mpfr_t y, mpfr_t xq, mpfr_t ysqr, mpfr_t q, mpfr_t t) {
+        mpfr_sqr(ysqr, y, MPFR_RNDN);
+
+        // Cardioïde: q(q + (x - 1/4)) <= y²/4 avec q = (x - 1/4)² + y²
+        mpfr_sub_d(xq, x, 0.25, MPFR_RNDN);
+        mpfr_sqr(q, xq, MPFR_RNDN);
+        mpfr_add(q, q, ysqr, MPFR_RNDN);
+        mpfr_add(t, q, xq, MPFR_RNDN);
+        mpfr_mul(t, t, q, MPFR_RNDN);
+        mpfr_mul_2si(q, ysqr, -2, MPFR_RNDN);
+        if (mpfr_cmp(t, q) <= 0)
+            return true;
+
+        // Disque de centre -1 et de rayon 1/4
+        mpfr_add_d(xq, x, 1.0, MPFR_RNDN);
+        mpfr_sqr(xq, xq, MPFR_RNDN);
+        mpfr_add(xq, xq, ysqr, MPFR_RNDN);
+        return mpfr_cmp_d(xq, 0.0625) <= 0;
+    }
+
+    // Variables de travail MPFR d'un thread de calcul, pointées par WorkerContext.scratch
+    typedef struct {
+        mpfr_t x0, y0, x, y, xtemp, xsqr, ysqr, sum;
+        mpfr_t two, four, offsetX, offsetY, inv_zoom, px_shifted, py_shifted;
+        mpfr_t checkX, checkY, diff;
+        mpfr_exp_t periodicityExponent;
+    } HighPrecisionScratch;
+
+    static void high_precision_scratch_init(HighPrecisionScratch *s, const FractalTask *task, mpfr_prec_t precision) {
+        mpfr_inits2(precision, s->x0, s->y0, s->x, s->y, s->xtemp, s->xsqr, s->ysqr, s->sum, s->two, s->four,
+                    s->offsetX, s->offsetY, s->inv_zoom, s->px_shifted, s->py_shifted,
+                    s->checkX, s->checkY, s->diff, (mpfr_ptr) 0);
+
+        mpfr_set_d(s->two, 2.0, MPFR_RNDN);
+        mpfr_set_d(s->four, 4.0, MPFR_RNDN);
+        mpfr_set(s->offsetX, task->centerX, MPFR_RNDN);
+        mpfr_set(s->offsetY, task->centerY, MPFR_RNDN);
+
+        // Inverser zoom pour éviter de diviser à chaque pixel
+        mpfr_set_d(s->inv_zoom, task->pixelSize.mantissa, MPFR_RNDN);
+        mpfr_mul_2si(s->inv_zoom, s->inv_zoom, task->pixelSize.exponent, MPFR_RNDN);
+
+        // Tolérance de PERIODICITY_TOLERANCE à zoom 1, resserrée comme la taille d'un pixel quand on zoome,
+        // sans descendre sous la marge de la précision de calcul (sinon l'orbite n'y arriverait jamais)
+        s->periodicityExponent = -(53 - PERIODICITY_GUARD_BITS) + smallest(0, task->pixelSize.exponent);
+        s->periodicityExponent = largest(s->periodicityExponent, -(mpfr_exp_t)(precision - PERIODICITY_GUARD_BITS));
+    }
+
+    static void high_precision_scratch_clear(HighPrecisionScratch *s) {
+        mpfr_clears(s->x0, s->y0, s->x, s->y, s->xtemp, s->xsqr, s->ysqr, s->sum,
+                    s->two, s->four, s->offsetX, s->offsetY, s->inv_zoom,
+                    s->px_shifted, s->py_shifted, s->checkX, s->checkY, s->diff, (mpfr_ptr) 0);
+    }
+
+    // Calcule une portion de ligne en haute précision, ctx->scratch doit pointer sur un HighPrecisionScratch
+    void calculate_iterations_high_precision_span(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) {
+        HighPrecisionScratch *s = (HighPrecisionScratch*)ctx->scratch;
+
+        int w = task->width;
+        double half_w = w / 2.0;
+        double half_h = task->height / 2.0;
+
+        mpfr_set_d(s->py_shifted, py - half_h, MPFR_RNDN);
+        mpfr_mul(s->y0, s->py_shifted, s->inv_zoom, MPFR_RNDN);
+        mpfr_add(s->y0, s->y0, s->offsetY, MPFR_RNDN);
+
+        bool checkPeriodicity = ctx->checkPeriodicity;
+
+        for (int px = xStart; px < xEnd; px++) {
+            mpfr_set_d(s->px_shifted, px - half_w, MPFR_RNDN);
+            mpfr_mul(s->x0, s->px_shifted, s->inv_zoom, MPFR_RNDN);
+            mpfr_add(s->x0, s->x0, s->offsetX, MPFR_RNDN);
+
+            // Intérieur connu: inutile d'itérer
+            if (in_main_cardioid_or_bulb_mpfr(s->x0, s->y0, s->xtemp, s->ysqr, s->xsqr, s->sum)) {
+                task->iterationMap[py * w + px] = task->max_iteration;
+                checkPeriodicity = true;
+                continue;
+            }
+
+            mpfr_set_d(s->x, 0.0, MPFR_RNDN);
+            mpfr_set_d(s->y, 0.0, MPFR_RNDN);
+            mpfr_set_d(s->checkX, 0.0, MPFR_RNDN);
+            mpfr_set_d(s->checkY, 0.0, MPFR_RNDN);
+
+            int iteration = 0;
+
+            while (iteration < task->max_iteration) {
+                mpfr_sqr(s->xsqr, s->x, MPFR_RNDN);    // xsqr = x^2
+                mpfr_sqr(s->ysqr, s->y, MPFR_RNDN);    // ysqr = y^2
+                mpfr_add(s->sum, s->xsqr, s->ysqr, MPFR_RNDN);
+
+                if (mpfr_cmp(s->sum, s->four) > 0) break;
+
+                mpfr_sub(s->xtemp, s->xsqr, s->ysqr, MPFR_RNDN);   // xtemp = x^2 - y^2
+                mpfr_add(s->xtemp, s->xtemp, s->x0, MPFR_RNDN);    // xtemp += x0
+
+                mpfr_mul(s->y, s->x, s->y, MPFR_RNDN);
+                mpfr_mul(s->y, s->y, s->two, MPFR_RNDN);
+                mpfr_add(s->y, s->y, s->y0, MPFR_RNDN);
+
+                mpfr_set(s->x, s->xtemp, MPFR_RNDN);
+
+                iteration++;
+
+                if (checkPeriodicity) {
+                    // Deux points confondus si leur écart est sous la marge, composante par composante
+                    mpfr_sub(s->diff, s->x, s->checkX, MPFR_RNDN);
+                    bool closeX = mpfr_zero_p(s->diff) || mpfr_get_exp(s->diff) <= s->periodicityExponent;
+                    mpfr_sub(s->diff, s->y, s->checkY, MPFR_RNDN);
+                    bool closeY = mpfr_zero_p(s->diff) || mpfr_get_exp(s->diff) <= s->periodicityExponent;
+
+                    if (closeX && closeY) {
+                        ctx->iterationsSaved += task->max_iteration - iteration;
+                        iteration = task->max_iteration;
+                        break;
+                    }
+
+                    if (periodicity_checkpoint(iteration)) {
+                        mpfr_set(s->checkX, s->x, MPFR_RNDN);
+                        mpfr_set(s->checkY, s->y, MPFR_RNDN);
+                    }
+                }
+            }
+
+            checkPeriodicity = (iteration == task->max_iteration);
+            task->iterationMap[py * w + px] = iteration;
+        }
+
+        ctx->checkPeriodicity = checkPeriodicity;
+    }
+
+    mpfr_prec_t high_precision_bits(const FractalTask *task) {
+        return (mpfr_prec_t)largest(pixel_precision_bits(task) + HIGH_PRECISION_GUARD_BITS, 53);
+    }
+
+    void high_precision_scratch_create(const FractalTask *task, WorkerContext *ctx) {
+        HighPrecisionScratch *scratch = malloc(sizeof(HighPrecisionScratch));
+        high_precision_scratch_init(scratch, task, high_precision_bits(task));
+        ctx->scratch = scratch;
+    }
+
+    void high_precision_scratch_destroy(const FractalTask *task, WorkerContext *ctx) {
+        (void)task;
+        high_precision_scratch_clear((HighPrecisionScratch*)ctx->scratch);
+        free(ctx->scratch);
+        ctx->scratch = NULL;
+    }
+#endif
+
@@ -0,0 +1,439 @@
+/*
+
+    Noyaux de calcul en double-double
+
+    Environ 106 bits de mantisse avec les seuls flottants du processeur: de quoi
+    dépasser les 1e13 de zoom du double sans passer par MPFR. Le centre de la vue
+    est donné en double-double (offsetX + offsetXLow) et chaque pixel en est écarté
+    de (px - w/2) fois la taille d'un pixel, produit calculé exactement.
+
+    Les variantes vectorisées font exactement les mêmes opérations que le noyau
+    scalaire, voie par voie, avec le FMA pour l'erreur des produits: les cartes
+    d'itérations sont identiques bit à bit.
+
+*/
+
+#include <math.h>
+
+#include <SDL2/SDL.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+#endif
+
+#include "kernels.h"
+#include "interior.h"
+#include "double_double.h"
+
+
+// Tolérance de périodicité: resserrée comme la taille d'un pixel, sans descendre sous la marge des 106 bits
+static double double_double_tolerance(const FractalTask *task) {
+    int exponent = -(53 - PERIODICITY_GUARD_BITS) + smallest(0, task->pixelSize.exponent);
+    exponent = largest(exponent, -(106 - PERIODICITY_GUARD_BITS));
+    return ldexp(1.0, exponent);
+}
+
+// Coordonnée du pixel d'indice index (depuis le centre) autour de center
+static inline doubledouble pixel_coordinate(double center, double centerLow, double index, double pixel) {
+    return dd_add(dd_make(center, centerLow), dd_prod_d(index, pixel));
+}
+
+bool double_double_pixels_distinct(const FractalTask *task) {
+    double pixel = fe_to_double(task->pixelSize);
+    double tolerance = ldexp(pixel, -PRECISION_TIER_GUARD_BITS);
+
+    for (int px = 1; px < task->width; px++) {
+        doubledouble step = dd_sub(pixel_coordinate(task->offsetX, task->offsetXLow, px - task->width / 2.0, pixel),
+                                   pixel_coordinate(task->offsetX, task->offsetXLow, px - 1 - task->width / 2.0, pixel));
+        if (!(fabs(step.hi - pixel) <= tolerance))
+            return false;
+    }
+    for (int py = 1; py < task->height; py++) {
+        doubledouble step = dd_sub(pixel_coordinate(task->offsetY, task->offsetYLow, py - task->height / 2.0, pixel),
+                                   pixel_coordinate(task->offsetY, task->offsetYLow, py - 1 - task->height / 2.0, pixel));
+        if (!(fabs(step.hi - pixel) <= tolerance))
+            return false;
+    }
+    return true;
+}
+
+
+void calculate_iterations_double_double(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) {
+    int w = task->width;
+    int h = task->height;
+    int *row = task->iterationMap + py * w;
+
+    double pixel = fe_to_double(task->pixelSize);
+    double tolerance = double_double_tolerance(task);
+    doubledouble y0 = pixel_coordinate(task->offsetY, task->offsetYLow, py - h / 2.0, pixel);
+
+    bool checkPeriodicity = ctx->checkPeriodicity;
+
+    for (int px = xStart; px < xEnd; px++) {
+        doubledouble x0 = pixel_coordinate(task->offsetX, task->offsetXLow, px - w / 2.0, pixel);
+
+        // Test en double: un point mal classé serait à moins de 1e-16 du bord, où l'orbite
+        // met de l'ordre de 1e8 itérations à s'échapper
+        if (in_main_cardioid_or_bulb(x0.hi, y0.hi)) {
+            row[px] = task->max_iteration;
+            checkPeriodicity = true;
+            continue;
+        }
+
+        doubledouble x = dd_make(0.0, 0.0), y = dd_make(0.0, 0.0);
+        doubledouble checkX = x, checkY = y;
+        int iteration = 0;
+
+        while (iteration < task->max_iteration) {
+            doubledouble xsqr = dd_sqr(x);
+            doubledouble ysqr = dd_sqr(y);
+            if (!(xsqr.hi + ysqr.hi <= 4.0))
+                break;
+
+            doubledouble xy = dd_mul(x, y);
+            x = dd_add(dd_sub(xsqr, ysqr), x0);
+            y = dd_add(dd_make(2.0 * xy.hi, 2.0 * xy.lo), y0);
+            iteration++;
+
+            if (checkPeriodicity) {
+                if (fabs(dd_sub(x, checkX).hi) < tolerance && fabs(dd_sub(y, checkY).hi) < tolerance) {
+                    ctx->iterationsSaved += task->max_iteration - iteration;
+                    iteration = task->max_iteration;
+                    break;
+                }
+
+                if (periodicity_checkpoint(iteration)) {
+                    checkX = x;
+                    checkY = y;
+                }
+            }
+        }
+
+        row[px] = iteration;
+        checkPeriodicity = (iteration == task->max_iteration);
+    }
+
+    ctx->checkPeriodicity = checkPeriodicity;
+}
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Opérations double-double sur 4 voies, mêmes étapes que double_double.h
+typedef struct {
+    __m256d hi, lo;
+} dd256;
+
+__attribute__((target("avx2,fma")))
+static inline __m256d two_sum_avx2(__m256d a, __m256d b, __m256d *e) {
+    __m256d s = _mm256_add_pd(a, b);
+    __m256d bb = _mm256_sub_pd(s, a);
+    *e = _mm256_add_pd(_mm256_sub_pd(a, _mm256_sub_pd(s, bb)), _mm256_sub_pd(b, bb));
+    return s;
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256d quick_two_sum_avx2(__m256d a, __m256d b, __m256d *e) {
+    __m256d s = _mm256_add_pd(a, b);
+    *e = _mm256_sub_pd(b, _mm256_sub_pd(s, a));
+    return s;
+}
+
+__attribute__((target("avx2,fma")))
+static inline dd256 dd_add_avx2(dd256 a, dd256 b) {
+    __m256d e, f;
+    __m256d s = two_sum_avx2(a.hi, b.hi, &e);
+    __m256d t = two_sum_avx2(a.lo, b.lo, &f);
+    e = _mm256_add_pd(e, t);
+    s = quick_two_sum_avx2(s, e, &e);
+    e = _mm256_add_pd(e, f);
+    s = quick_two_sum_avx2(s, e, &e);
+    dd256 r = { s, e };
+    return r;
+}
+
+__attribute__((target("avx2,fma")))
+static inline dd256 dd_sub_avx2(dd256 a, dd256 b) {
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    dd256 nb = { _mm256_xor_pd(b.hi, signBit), _mm256_xor_pd(b.lo, signBit) };
+    return dd_add_avx2(a, nb);
+}
+
+__attribute__((target("avx2,fma")))
+static inline dd256 dd_mul_avx2(dd256 a, dd256 b) {
+    __m256d p = _mm256_mul_pd(a.hi, b.hi);
+    __m256d e = _mm256_fmsub_pd(a.hi, b.hi, p);
+    e = _mm256_add_pd(e, _mm256_add_pd(_mm256_mul_pd(a.hi, b.lo), _mm256_mul_pd(a.lo, b.hi)));
+    p = quick_two_sum_avx2(p, e, &e);
+    dd256 r = { p, e };
+    return r;
+}
+
+__attribute__((target("avx2,fma")))
+static inline dd256 dd_sqr_avx2(dd256 a) {
+    __m256d p = _mm256_mul_pd(a.hi, a.hi);
+    __m256d e = _mm256_fmsub_pd(a.hi, a.hi, p);
+    e = _mm256_add_pd(e, _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(2.0), a.hi), a.lo));
+    p = quick_two_sum_avx2(p, e, &e);
+    dd256 r = { p, e };
+    return r;
+}
+
+// 4 pixels à la fois avec AVX2 et FMA
+__attribute__((target("avx2,fma")))
+void calculate_iterations_double_double_avx2(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) {
+    int w = task->width;
+    int h = task->height;
+    int *row = task->iterationMap + py * w;
+
+    double pixel = fe_to_double(task->pixelSize);
+    doubledouble y0Row = pixel_coordinate(task->offsetY, task->offsetYLow, py - h / 2.0, pixel);
+
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d maxIteration = _mm256_set1_pd((double)task->max_iteration);
+    const __m256d laneIndex = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    const __m256d tolerance = _mm256_set1_pd(double_double_tolerance(task));
+    const dd256 y0 = { _mm256_set1_pd(y0Row.hi), _mm256_set1_pd(y0Row.lo) };
+
+    // Périodicité vérifiée seulement si le groupe précédent avait un pixel qui n'a pas pu s'échapper
+    bool checkPeriodicity = ctx->checkPeriodicity;
+
+    for (int px = xStart; px < xEnd; px += 4) {
+        int lanes = smallest(4, xEnd - px);
+
+        // Coordonnées calculées comme le noyau scalaire, puis chargées dans les voies
+        double laneX0[4] = { 0.0 }, laneX0Low[4] = { 0.0 }, laneInterior[4] = { 0.0 };
+        for (int lane = 0; lane < lanes; lane++) {
+            doubledouble x0 = pixel_coordinate(task->offsetX, task->offsetXLow, px + lane - w / 2.0, pixel);
+            laneX0[lane] = x0.hi;
+            laneX0Low[lane] = x0.lo;
+            laneInterior[lane] = in_main_cardioid_or_bulb(x0.hi, y0Row.hi) ? task->max_iteration : 0.0;
+        }
+        const dd256 x0 = { _mm256_loadu_pd(laneX0), _mm256_loadu_pd(laneX0Low) };
+
+        // Les voies au-delà de la fin de la portion sont inactives dès le départ
+        __m256d valid = _mm256_cmp_pd(laneIndex, _mm256_set1_pd((double)lanes), _CMP_LT_OQ);
+        __m256d active = valid;
+
+        dd256 x = { _mm256_setzero_pd(), _mm256_setzero_pd() };
+        dd256 y = x, checkX = x, checkY = x;
+
+        // Les pixels de l'intérieur connu partent directement au maximum, leur voie est donc inactive
+        __m256d iteration = _mm256_loadu_pd(laneInterior);
+
+        for (int step = 1; ; step++) {
+            dd256 xsqr = dd_sqr_avx2(x);
+            dd256 ysqr = dd_sqr_avx2(y);
+
+            active = _mm256_and_pd(active, _mm256_cmp_pd(_mm256_add_pd(xsqr.hi, ysqr.hi), four, _CMP_LE_OQ));
+            active = _mm256_and_pd(active, _mm256_cmp_pd(iteration, maxIteration, _CMP_LT_OQ));
+            if (_mm256_movemask_pd(active) == 0)
+                break;
+
+            iteration = _mm256_add_pd(iteration, _mm256_and_pd(active, one));
+
+            dd256 xy = dd_mul_avx2(x, y);
+            xy.hi = _mm256_mul_pd(two, xy.hi);
+            xy.lo = _mm256_mul_pd(two, xy.lo);
+            x = dd_add_avx2(dd_sub_avx2(xsqr, ysqr), x0);
+            y = dd_add_avx2(xy, y0);
+
+            if (checkPeriodicity) {
+                __m256d dx = _mm256_andnot_pd(signBit, dd_sub_avx2(x, checkX).hi);
+                __m256d dy = _mm256_andnot_pd(signBit, dd_sub_avx2(y, checkY).hi);
+                __m256d periodic = _mm256_and_pd(active, _mm256_and_pd(_mm256_cmp_pd(dx, tolerance, _CMP_LT_OQ),
+                                                                       _mm256_cmp_pd(dy, tolerance, _CMP_LT_OQ)));
+
+                int periodicMask = _mm256_movemask_pd(periodic);
+                if (periodicMask) {
+                    double laneIteration[4];
+                    _mm256_storeu_pd(laneIteration, iteration);
+                    for (int lane = 0; lane < 4; lane++) {
+                        if (periodicMask & (1 << lane))
+                            ctx->iterationsSaved += task->max_iteration - (int)laneIteration[lane];
+                    }
+
+                    iteration = _mm256_blendv_pd(iteration, maxIteration, periodic);
+                    active = _mm256_andnot_pd(periodic, active);
+                }
+
+                // Les voies actives ont toutes fait step itérations, le point gardé change en même temps
+                if (periodicity_checkpoint(step)) {
+                    checkX = x;
+                    checkY = y;
+                }
+            }
+        }
+
+        checkPeriodicity = _mm256_movemask_pd(_mm256_and_pd(valid, _mm256_cmp_pd(iteration, maxIteration, _CMP_EQ_OQ))) != 0;
+
+        double result[4];
+        _mm256_storeu_pd(result, iteration);
+        for (int lane = 0; lane < lanes; lane++) {
+            row[px + lane] = (int)result[lane];
+        }
+    }
+
+    ctx->checkPeriodicity = checkPeriodicity;
+}
+
+
+// Mêmes opérations sur 8 voies, AVX-512F comprend le FMA
+typedef struct {
+    __m512d hi, lo;
+} dd512;
+
+__attribute__((target("avx512f")))
+static inline __m512d two_sum_avx512(__m512d a, __m512d b, __m512d *e) {
+    __m512d s = _mm512_add_pd(a, b);
+    __m512d bb = _mm512_sub_pd(s, a);
+    *e = _mm512_add_pd(_mm512_sub_pd(a, _mm512_sub_pd(s, bb)), _mm512_sub_pd(b, bb));
+    return s;
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d quick_two_sum_avx512(__m512d a, __m512d b, __m512d *e) {
+    __m512d s = _mm512_add_pd(a, b);
+    *e = _mm512_sub_pd(b, _mm512_sub_pd(s, a));
+    return s;
+}
+
+__attribute__((target("avx512f")))
+static inline dd512 dd_add_avx512(dd512 a, dd512 b) {
+    __m512d e, f;
+    __m512d s = two_sum_avx512(a.hi, b.hi, &e);
+    __m512d t = two_sum_avx512(a.lo, b.lo, &f);
+    e = _mm512_add_pd(e, t);
+    s = quick_two_sum_avx512(s, e, &e);
+    e = _mm512_add_pd(e, f);
+    s = quick_two_sum_avx512(s, e, &e);
+    dd512 r = { s, e };
+    return r;
+}
+
+__attribute__((target("avx512f")))
+static inline dd512 dd_sub_avx512(dd512 a, dd512 b) {
+    const __m512i signBit = _mm512_set1_epi64((long long)0x8000000000000000ULL);
+    dd512 nb = { _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(b.hi), signBit)),
+                 _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(b.lo), signBit)) };
+    return dd_add_avx512(a, nb);
+}
+
+__attribute__((target("avx512f")))
+static inline dd512 dd_mul_avx512(dd512 a, dd512 b) {
+    __m512d p = _mm512_mul_pd(a.hi, b.hi);
+    __m512d e = _mm512_fmsub_pd(a.hi, b.hi, p);
+    e = _mm512_add_pd(e, _mm512_add_pd(_mm512_mul_pd(a.hi, b.lo), _mm512_mul_pd(a.lo, b.hi)));
+    p = quick_two_sum_avx512(p, e, &e);
+    dd512 r = { p, e };
+    return r;
+}
+
+__attribute__((target("avx512f")))
+static inline dd512 dd_sqr_avx512(dd512 a) {
+    __m512d p = _mm512_mul_pd(a.hi, a.hi);
+    __m512d e = _mm512_fmsub_pd(a.hi, a.hi, p);
+    e = _mm512_add_pd(e, _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(2.0), a.hi), a.lo));
+    p = quick_two_sum_avx512(p, e, &e);
+    dd512 r = { p, e };
+    return r;
+}
+
+// 8 pixels à la fois avec AVX-512, les voies actives sont un masque de bits
+__attribute__((target("avx512f")))
+void calculate_iterations_double_double_avx512(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) {
+    int w = task->width;
+    int h = task->height;
+    int *row = task->iterationMap + py * w;
+
+    double pixel = fe_to_double(task->pixelSize);
+    doubledouble y0Row = pixel_coordinate(task->offsetY, task->offsetYLow, py - h / 2.0, pixel);
+
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d maxIteration = _mm512_set1_pd((double)task->max_iteration);
+    const __m512d tolerance = _mm512_set1_pd(double_double_tolerance(task));
+    const dd512 y0 = { _mm512_set1_pd(y0Row.hi), _mm512_set1_pd(y0Row.lo) };
+
+    // Périodicité vérifiée seulement si le groupe précédent avait un pixel qui n'a pas pu s'échapper
+    bool checkPeriodicity = ctx->checkPeriodicity;
+
+    for (int px = xStart; px < xEnd; px += 8) {
+        int lanes = smallest(8, xEnd - px);
+
+        double laneX0[8] = { 0.0 }, laneX0Low[8] = { 0.0 }, laneInterior[8] = { 0.0 };
+        for (int lane = 0; lane < lanes; lane++) {
+            doubledouble x0 = pixel_coordinate(task->offsetX, task->offsetXLow, px + lane - w / 2.0, pixel);
+            laneX0[lane] = x0.hi;
+            laneX0Low[lane] = x0.lo;
+            laneInterior[lane] = in_main_cardioid_or_bulb(x0.hi, y0Row.hi) ? task->max_iteration : 0.0;
+        }
+        const dd512 x0 = { _mm512_loadu_pd(laneX0), _mm512_loadu_pd(laneX0Low) };
+
+        __mmask8 valid = (__mmask8)((1u << lanes) - 1);
+        __mmask8 active = valid;
+
+        dd512 x = { _mm512_setzero_pd(), _mm512_setzero_pd() };
+        dd512 y = x, checkX = x, checkY = x;
+
+        // Les pixels de l'intérieur connu partent directement au maximum, leur voie est donc inactive
+        __m512d iteration = _mm512_loadu_pd(laneInterior);
+
+        for (int step = 1; ; step++) {
+            dd512 xsqr = dd_sqr_avx512(x);
+            dd512 ysqr = dd_sqr_avx512(y);
+
+            active = _mm512_mask_cmp_pd_mask(active, _mm512_add_pd(xsqr.hi, ysqr.hi), four, _CMP_LE_OQ);
+            active = _mm512_mask_cmp_pd_mask(active, iteration, maxIteration, _CMP_LT_OQ);
+            if (active == 0)
+                break;
+
+            iteration = _mm512_mask_add_pd(iteration, active, iteration, one);
+
+            dd512 xy = dd_mul_avx512(x, y);
+            xy.hi = _mm512_mul_pd(two, xy.hi);
+            xy.lo = _mm512_mul_pd(two, xy.lo);
+            x = dd_add_avx512(dd_sub_avx512(xsqr, ysqr), x0);
+            y = dd_add_avx512(xy, y0);
+
+            if (checkPeriodicity) {
+                __mmask8 periodic = _mm512_mask_cmp_pd_mask(active, _mm512_abs_pd(dd_sub_avx512(x, checkX).hi), tolerance, _CMP_LT_OQ);
+                periodic = _mm512_mask_cmp_pd_mask(periodic, _mm512_abs_pd(dd_sub_avx512(y, checkY).hi), tolerance, _CMP_LT_OQ);
+
+                if (periodic) {
+                    double laneIteration[8];
+                    _mm512_storeu_pd(laneIteration, iteration);
+                    for (int lane = 0; lane < 8; lane++) {
+                        if (periodic & (1 << lane))
+                            ctx->iterationsSaved += task->max_iteration - (int)laneIteration[lane];
+                    }
+
+                    iteration = _mm512_mask_mov_pd(iteration, periodic, maxIteration);
+                    active &= ~periodic;
+                }
+
+                // Les voies actives ont toutes fait step itérations, le point gardé change en même temps
+                if (periodicity_checkpoint(step)) {
+                    checkX = x;
+                    checkY = y;
+                }
+            }
+        }
+
+        checkPeriodicity = _mm512_mask_cmp_pd_mask(valid, iteration, maxIteration, _CMP_EQ_OQ) != 0;
+
+        double result[8];
+        _mm512_storeu_pd(result, iteration);
+        for (int lane = 0; lane < lanes; lane++) {
+            row[px + lane] = (int)result[lane];
+        }
+    }
+
+    ctx->checkPeriodicity = checkPeriodicity;
+}
+
+#endif
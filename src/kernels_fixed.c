@@ -0,0 +1,360 @@
+/*
+
+    Noyaux de calcul en virgule fixe sur plusieurs limbs de 64 bits
+
+    Au-delà du double-double, MPFR fait à chaque opération le travail d'un
+    flottant général: arrondis, exposants, mémoire allouée. Dans le Mandelbrot
+    tout reste entre -128 et 128 avant le test d'échappement, la virgule fixe
+    suffit: un nombre est un entier signé en complément à deux de n limbs
+    (limb 0 le moins significatif), valant entier / 2^(64 n - FIXED_INT_BITS).
+
+    Les fonctions prennent le nombre de limbs en paramètre mais sont toujours
+    inlinées dans des noyaux instanciés pour 2, 3, 4, 6 et 8 limbs, où il est
+    constant: les boucles sur les limbs y sont entièrement déroulées.
+
+    Les produits sont tronqués, les colonnes de poids trop faible pour changer
+    le résultat de plus d'une unité du dernier bit ne sont pas calculées.
+
+*/
+
+#include <string.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+
+// Seulement pour la version linux
+#ifdef __linux__
+    #include <mpfr.h>
+    #include <gmp.h>
+#endif
+
+#include "kernels.h"
+#include "interior.h"
+
+
+#ifdef __linux__
+
+// Bits de la partie entière, signe compris: les valeurs restent sous 128 en valeur absolue
+#define FIXED_INT_BITS 8
+
+// Plus grand nombre de limbs des noyaux instanciés
+#define FIXED_MAX_LIMBS 8
+
+#define FIXED_INLINE static inline __attribute__((always_inline))
+
+typedef unsigned __int128 uint128;
+
+
+// Bits après la virgule pour n limbs
+#define FIXED_FRACTION_BITS(n) (64 * (n) - FIXED_INT_BITS)
+
+FIXED_INLINE bool fixed_negative(const uint64_t *a, int n) {
+    return (a[n - 1] >> 63) != 0;
+}
+
+FIXED_INLINE void fixed_add(uint64_t *r, const uint64_t *a, const uint64_t *b, int n) {
+    uint64_t carry = 0;
+    for (int i = 0; i < n; i++) {
+        uint128 s = (uint128)a[i] + b[i] + carry;
+        r[i] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+}
+
+FIXED_INLINE void fixed_sub(uint64_t *r, const uint64_t *a, const uint64_t *b, int n) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < n; i++) {
+        uint128 d = (uint128)a[i] - b[i] - borrow;
+        r[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+}
+
+FIXED_INLINE void fixed_neg(uint64_t *r, const uint64_t *a, int n) {
+    uint64_t carry = 1;
+    for (int i = 0; i < n; i++) {
+        uint128 s = (uint128)(~a[i]) + carry;
+        r[i] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+}
+
+FIXED_INLINE void fixed_abs(uint64_t *r, const uint64_t *a, int n) {
+    if (fixed_negative(a, n))
+        fixed_neg(r, a, n);
+    else
+        memcpy(r, a, n * sizeof(uint64_t));
+}
+
+// Le produit a 2 FIXED_FRACTION_BITS(n) bits après la virgule, on en garde FIXED_FRACTION_BITS(n)
+// En décalant d'un bit de moins, le résultat est doublé gratuitement (2xy)
+FIXED_INLINE void fixed_take_high(uint64_t *r, const uint64_t *product, int n, bool doubled) {
+    int shift = FIXED_INT_BITS + (doubled ? 1 : 0);
+    #pragma GCC unroll 8
+    for (int k = 0; k < n; k++) {
+        r[k] = (product[n - 1 + k] >> (64 - shift)) | (product[n + k] << shift);
+    }
+}
+
+// r = a * b pour a et b positifs, tronqué: les colonnes i + j < n - 2 ne sont pas calculées
+// Colonne par colonne, les moitiés basses et hautes des produits sont sommées à part:
+// deux additions indépendantes par produit au lieu d'une longue chaîne de retenues
+FIXED_INLINE void fixed_mul_unsigned(uint64_t *r, const uint64_t *a, const uint64_t *b, int n, bool doubled) {
+    uint64_t product[2 * FIXED_MAX_LIMBS];
+    uint128 carry = 0;
+
+    #pragma GCC unroll 16
+    for (int column = largest(0, n - 2); column < 2 * n - 1; column++) {
+        uint128 lowSum = (uint64_t)carry;
+        uint128 highSum = carry >> 64;
+
+        for (int i = largest(0, column - (n - 1)); i <= smallest(column, n - 1); i++) {
+            uint128 p = (uint128)a[i] * b[column - i];
+            lowSum += (uint64_t)p;
+            highSum += (uint64_t)(p >> 64);
+        }
+
+        product[column] = (uint64_t)lowSum;
+        carry = (lowSum >> 64) + highSum;
+    }
+    product[2 * n - 1] = (uint64_t)carry;
+
+    fixed_take_high(r, product, n, doubled);
+}
+
+// r = a² pour a positif, même parcours avec les termes croisés a_i a_j (i < j) calculés une fois et doublés
+FIXED_INLINE void fixed_sqr_unsigned(uint64_t *r, const uint64_t *a, int n) {
+    uint64_t product[2 * FIXED_MAX_LIMBS];
+    uint128 carry = 0;
+
+    #pragma GCC unroll 16
+    for (int column = largest(0, n - 2); column < 2 * n - 1; column++) {
+        uint128 crossLow = 0, crossHigh = 0;
+
+        for (int i = largest(0, column - (n - 1)); i < column - i; i++) {
+            uint128 p = (uint128)a[i] * a[column - i];
+            crossLow += (uint64_t)p;
+            crossHigh += (uint64_t)(p >> 64);
+        }
+
+        uint128 lowSum = (uint64_t)carry + 2 * crossLow;
+        uint128 highSum = (carry >> 64) + 2 * crossHigh;
+        if ((column & 1) == 0) {
+            uint128 p = (uint128)a[column / 2] * a[column / 2];
+            lowSum += (uint64_t)p;
+            highSum += (uint64_t)(p >> 64);
+        }
+
+        product[column] = (uint64_t)lowSum;
+        carry = (lowSum >> 64) + highSum;
+    }
+    product[2 * n - 1] = (uint64_t)carry;
+
+    fixed_take_high(r, product, n, false);
+}
+
+// r = a * k, exact tant qu'il n'y a pas de dépassement
+FIXED_INLINE void fixed_mul_int(uint64_t *r, const uint64_t *a, int64_t k, int n) {
+    uint64_t ua[FIXED_MAX_LIMBS];
+    fixed_abs(ua, a, n);
+    uint64_t uk = (k < 0) ? (uint64_t)(-k) : (uint64_t)k;
+
+    uint64_t carry = 0;
+    for (int i = 0; i < n; i++) {
+        uint128 p = (uint128)ua[i] * uk + carry;
+        r[i] = (uint64_t)p;
+        carry = (uint64_t)(p >> 64);
+    }
+    if (fixed_negative(a, n) != (k < 0))
+        fixed_neg(r, r, n);
+}
+
+// a > 4 pour a positif ou nul
+FIXED_INLINE bool fixed_greater_than_four(const uint64_t *a, int n) {
+    const uint64_t four = 1ULL << (64 - FIXED_INT_BITS + 2);
+    if (a[n - 1] != four)
+        return a[n - 1] > four;
+    for (int i = 0; i < n - 1; i++) {
+        if (a[i] != 0)
+            return true;
+    }
+    return false;
+}
+
+// |a| < 2^bit en unités du dernier bit
+FIXED_INLINE bool fixed_below(const uint64_t *a, int bit, int n) {
+    uint64_t ua[FIXED_MAX_LIMBS];
+    fixed_abs(ua, a, n);
+    int limb = bit / 64;
+    for (int i = n - 1; i > limb; i--) {
+        if (ua[i] != 0)
+            return false;
+    }
+    return ua[limb] < (1ULL << (bit % 64));
+}
+
+
+// Convertit un nombre MPFR en virgule fixe
+static void fixed_from_mpfr(uint64_t *r, mpfr_srcptr value, int n) {
+    mpfr_t scaled;
+    mpfr_init2(scaled, largest(mpfr_get_prec(value), (mpfr_prec_t)(64 * n)));
+    mpfr_mul_2si(scaled, value, FIXED_FRACTION_BITS(n), MPFR_RNDN);
+
+    mpz_t integer;
+    mpz_init(integer);
+    mpfr_get_z(integer, scaled, MPFR_RNDN);
+
+    memset(r, 0, n * sizeof(uint64_t));
+    size_t count = 0;
+    if (mpz_sizeinbase(integer, 2) < (size_t)(64 * n))
+        mpz_export(r, &count, -1, sizeof(uint64_t), 0, 0, integer);
+    if (mpz_sgn(integer) < 0)
+        fixed_neg(r, r, n);
+
+    mpz_clear(integer);
+    mpfr_clear(scaled);
+}
+
+// Position de la tolérance de périodicité en bits sous la virgule, comme le noyau MPFR
+static int fixed_periodicity_bit(const FractalTask *task, int n) {
+    int exponent = -(53 - PERIODICITY_GUARD_BITS) + smallest(0, task->pixelSize.exponent);
+    exponent = largest(exponent, -(FIXED_FRACTION_BITS(n) - PERIODICITY_GUARD_BITS));
+    return FIXED_FRACTION_BITS(n) + exponent;
+}
+
+
+FIXED_INLINE void fixed_span(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd, int n) {
+    int w = task->width;
+    int h = task->height;
+    int *row = task->iterationMap + py * w;
+
+    // Centre et demi-pixel en virgule fixe, puis coordonnées exactes des pixels de la portion
+    // Le pixel px est à (2 px - w) demi-pixels du centre, comme (px - w / 2.0) dans les autres noyaux
+    uint64_t centerX[FIXED_MAX_LIMBS], centerY[FIXED_MAX_LIMBS], halfStep[FIXED_MAX_LIMBS];
+    fixed_from_mpfr(centerX, task->centerX, n);
+    fixed_from_mpfr(centerY, task->centerY, n);
+
+    mpfr_t pixel;
+    mpfr_init2(pixel, 53);
+    mpfr_set_d(pixel, task->pixelSize.mantissa, MPFR_RNDN);
+    mpfr_mul_2si(pixel, pixel, task->pixelSize.exponent - 1, MPFR_RNDN);
+    fixed_from_mpfr(halfStep, pixel, n);
+    mpfr_clear(pixel);
+
+    uint64_t y0[FIXED_MAX_LIMBS], x0[FIXED_MAX_LIMBS], offset[FIXED_MAX_LIMBS];
+    fixed_mul_int(offset, halfStep, 2 * py - h, n);
+    fixed_add(y0, centerY, offset, n);
+
+    int periodicityBit = fixed_periodicity_bit(task, n);
+    bool checkPeriodicity = ctx->checkPeriodicity;
+
+    for (int px = xStart; px < xEnd; px++) {
+        fixed_mul_int(offset, halfStep, 2 * px - w, n);
+        fixed_add(x0, centerX, offset, n);
+
+        // Test en double, comme le noyau double-double
+        double x0d = (double)(int64_t)x0[n - 1] * 0x1p-56;
+        double y0d = (double)(int64_t)y0[n - 1] * 0x1p-56;
+        if (in_main_cardioid_or_bulb(x0d, y0d)) {
+            row[px] = task->max_iteration;
+            checkPeriodicity = true;
+            continue;
+        }
+
+        uint64_t x[FIXED_MAX_LIMBS] = { 0 }, y[FIXED_MAX_LIMBS] = { 0 };
+        uint64_t absX[FIXED_MAX_LIMBS], absY[FIXED_MAX_LIMBS];
+        uint64_t xsqr[FIXED_MAX_LIMBS], ysqr[FIXED_MAX_LIMBS], t[FIXED_MAX_LIMBS];
+        uint64_t checkX[FIXED_MAX_LIMBS] = { 0 }, checkY[FIXED_MAX_LIMBS] = { 0 };
+        int iteration = 0;
+
+        while (iteration < task->max_iteration) {
+            // Produits sur les valeurs absolues, le signe de xy est remis ensuite
+            fixed_abs(absX, x, n);
+            fixed_abs(absY, y, n);
+            fixed_sqr_unsigned(xsqr, absX, n);
+            fixed_sqr_unsigned(ysqr, absY, n);
+            fixed_add(t, xsqr, ysqr, n);
+            if (fixed_greater_than_four(t, n))
+                break;
+
+            // y = 2xy + y0, x = x² - y² + x0
+            fixed_mul_unsigned(t, absX, absY, n, true);
+            if (fixed_negative(x, n) != fixed_negative(y, n))
+                fixed_neg(t, t, n);
+            fixed_add(y, t, y0, n);
+            fixed_sub(x, xsqr, ysqr, n);
+            fixed_add(x, x, x0, n);
+            iteration++;
+
+            if (checkPeriodicity) {
+                fixed_sub(t, x, checkX, n);
+                bool closeX = fixed_below(t, periodicityBit, n);
+                fixed_sub(t, y, checkY, n);
+                if (closeX && fixed_below(t, periodicityBit, n)) {
+                    ctx->iterationsSaved += task->max_iteration - iteration;
+                    iteration = task->max_iteration;
+                    break;
+                }
+
+                if (periodicity_checkpoint(iteration)) {
+                    memcpy(checkX, x, n * sizeof(uint64_t));
+                    memcpy(checkY, y, n * sizeof(uint64_t));
+                }
+            }
+        }
+
+        row[px] = iteration;
+        checkPeriodicity = (iteration == task->max_iteration);
+    }
+
+    ctx->checkPeriodicity = checkPeriodicity;
+}
+
+
+// Un noyau par nombre de limbs, où n est une constante
+#define FIXED_KERNEL(n) \
+    static void calculate_iterations_fixed_##n(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) { \
+        fixed_span(task, ctx, py, xStart, xEnd, n); \
+    }
+
+FIXED_KERNEL(2)
+FIXED_KERNEL(3)
+FIXED_KERNEL(4)
+FIXED_KERNEL(6)
+FIXED_KERNEL(8)
+
+static const struct {
+    int limbs;
+    SpanKernel kernel;
+} fixed_kernels[] = {
+    { 2, calculate_iterations_fixed_2 },
+    { 3, calculate_iterations_fixed_3 },
+    { 4, calculate_iterations_fixed_4 },
+    { 6, calculate_iterations_fixed_6 },
+    { 8, calculate_iterations_fixed_8 },
+};
+
+int fixed_point_limbs(const FractalTask *task) {
+    // Toute l'image doit tenir loin sous la limite de la partie entière
+    double extent = fe_to_double(fe_mul_d(task->pixelSize, hypot(task->width, task->height) / 2.0));
+    if (hypot(task->offsetX, task->offsetY) + extent > 4.0)
+        return 0;
+
+    mpfr_prec_t bits = high_precision_bits(task);
+    for (size_t i = 0; i < sizeof(fixed_kernels) / sizeof(fixed_kernels[0]); i++) {
+        if (FIXED_FRACTION_BITS(fixed_kernels[i].limbs) >= bits)
+            return fixed_kernels[i].limbs;
+    }
+    return 0;
+}
+
+SpanKernel fixed_point_kernel(const FractalTask *task) {
+    int limbs = fixed_point_limbs(task);
+    for (size_t i = 0; i < sizeof(fixed_kernels) / sizeof(fixed_kernels[0]); i++) {
+        if (fixed_kernels[i].limbs == limbs)
+            return fixed_kernels[i].kernel;
+    }
+    return NULL;
+}
+
+#endif
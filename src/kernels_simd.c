@@ -0,0 +1,717 @@
+
+/*
+
+    Noyaux vectorisés du calcul en double précision
+
+    Plusieurs pixels voisins d'une ligne sont itérés en même temps, un par voie
+    du registre. Une voie dont le pixel s'est échappé ou a atteint le maximum
+    d'itérations est masquée: son compteur ne bouge plus, les autres continuent.
+    Les opérations sont faites dans le même ordre que calculate_iterations
+    (sans FMA, voir -ffp-contract=off dans le Makefile), les cartes d'itérations
+    sont donc identiques bit à bit à celles du noyau scalaire.
+
+*/
+
+#include <SDL2/SDL.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+#endif
+
+#include "kernels.h"
+#include "interior.h"
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Voies dans la cardioïde principale ou le disque de période 2, même calcul que in_main_cardioid_or_bulb
+__attribute__((target("sse2")))
+static inline __m128d interior_sse2(__m128d x, __m128d y) {
+    __m128d ysqr = _mm_mul_pd(y, y);
+    __m128d xq = _mm_sub_pd(x, _mm_set1_pd(0.25));
+    __m128d q = _mm_add_pd(_mm_mul_pd(xq, xq), ysqr);
+    __m128d cardioid = _mm_cmple_pd(_mm_mul_pd(q, _mm_add_pd(q, xq)), _mm_mul_pd(_mm_set1_pd(0.25), ysqr));
+    __m128d xb = _mm_add_pd(x, _mm_set1_pd(1.0));
+    __m128d bulb = _mm_cmple_pd(_mm_add_pd(_mm_mul_pd(xb, xb), ysqr), _mm_set1_pd(0.0625));
+    return _mm_or_pd(cardioid, bulb);
+}
+
+__attribute__((target("avx2")))
+static inline __m256d interior_avx2(__m256d x, __m256d y) {
+    __m256d ysqr = _mm256_mul_pd(y, y);
+    __m256d xq = _mm256_sub_pd(x, _mm256_set1_pd(0.25));
+    __m256d q = _mm256_add_pd(_mm256_mul_pd(xq, xq), ysqr);
+    __m256d cardioid = _mm256_cmp_pd(_mm256_mul_pd(q, _mm256_add_pd(q, xq)), _mm256_mul_pd(_mm256_set1_pd(0.25), ysqr), _CMP_LE_OQ);
+    __m256d xb = _mm256_add_pd(x, _mm256_set1_pd(1.0));
+    __m256d bulb = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(xb, xb), ysqr), _mm256_set1_pd(0.0625), _CMP_LE_OQ);
+    return _mm256_or_pd(cardioid, bulb);
+}
+
+__attribute__((target("avx512f")))
+static inline __mmask8 interior_avx512(__m512d x, __m512d y) {
+    __m512d ysqr = _mm512_mul_pd(y, y);
+    __m512d xq = _mm512_sub_pd(x, _mm512_set1_pd(0.25));
+    __m512d q = _mm512_add_pd(_mm512_mul_pd(xq, xq), ysqr);
+    __mmask8 cardioid = _mm512_cmp_pd_mask(_mm512_mul_pd(q, _mm512_add_pd(q, xq)), _mm512_mul_pd(_mm512_set1_pd(0.25), ysqr), _CMP_LE_OQ);
+    __m512d xb = _mm512_add_pd(x, _mm512_set1_pd(1.0));
+    __mmask8 bulb = _mm512_cmp_pd_mask(_mm512_add_pd(_mm512_mul_pd(xb, xb), ysqr), _mm512_set1_pd(0.0625), _CMP_LE_OQ);
+    return cardioid | bulb;
+}
+
+
+// Compte les itérations évitées par les voies déclarées périodiques
+static inline void count_saved_iterations(WorkerContext *ctx, const double *laneIteration, int periodicMask, int maxIteration) {
+    for (int lane = 0; periodicMask; lane++, periodicMask >>= 1) {
+        if (periodicMask & 1)
+            ctx->iterationsSaved += maxIteration - (int)laneIteration[lane];
+    }
+}
+
+
+// Ecrit l'état gardé des voies valides d'un groupe, à partir du pixel index
+static inline void keep_lanes(const FractalTask *task, int index, const double *laneX, const double *laneY, int lanes) {
+    for (int lane = 0; lane < lanes; lane++) {
+        task->resumeX[index + lane] = laneX[lane];
+        task->resumeY[index + lane] = laneY[lane];
+    }
+}
+
+
+// 2 pixels à la fois avec SSE2, disponible sur tous les processeurs x86-64
+__attribute__((target("sse2")))
+void calculate_iterations_sse2(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) {
+    int w = task->width;
+    int h = task->height;
+    int *row = task->iterationMap + py * w;
+
+    const __m128d four = _mm_set1_pd(4.0);
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d maxIteration = _mm_set1_pd((double)task->max_iteration);
+    const __m128d halfW = _mm_set1_pd(w / 2.0);
+    const __m128d zoom = _mm_set1_pd(task->zoom);
+    const __m128d offsetX = _mm_set1_pd(task->offsetX);
+    const __m128d y0 = _mm_set1_pd((py - h / 2.0) / task->zoom + task->offsetY);
+    const __m128d laneIndex = _mm_set_pd(1.0, 0.0);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+    const __m128d tolerance = _mm_set1_pd(PERIODICITY_TOLERANCE);
+
+    // Périodicité vérifiée seulement si le groupe précédent avait un pixel qui n'a pas pu s'échapper
+    bool checkPeriodicity = ctx->checkPeriodicity;
+
+    for (int px = xStart; px < xEnd; px += 2) {
+        int lanes = smallest(2, xEnd - px);
+
+        __m128d pxLanes = _mm_add_pd(_mm_set1_pd((double)px), laneIndex);
+        __m128d x0 = _mm_add_pd(_mm_div_pd(_mm_sub_pd(pxLanes, halfW), zoom), offsetX);
+
+        __m128d valid = _mm_cmplt_pd(laneIndex, _mm_set1_pd((double)lanes));
+        __m128d active = valid;
+
+        __m128d x = _mm_setzero_pd();
+        __m128d y = _mm_setzero_pd();
+        __m128d checkX = _mm_setzero_pd();
+        __m128d checkY = _mm_setzero_pd();
+        __m128d keptX = _mm_set1_pd(NAN);
+        __m128d keptY = _mm_set1_pd(NAN);
+
+        // Les pixels de l'intérieur connu partent directement au maximum, leur voie est donc inactive
+        __m128d iteration = _mm_and_pd(interior_sse2(x0, y0), maxIteration);
+
+        for (int step = 1; ; step++) {
+            __m128d xsqr = _mm_mul_pd(x, x);
+            __m128d ysqr = _mm_mul_pd(y, y);
+
+            active = _mm_and_pd(active, _mm_cmple_pd(_mm_add_pd(xsqr, ysqr), four));
+            active = _mm_and_pd(active, _mm_cmplt_pd(iteration, maxIteration));
+            if (_mm_movemask_pd(active) == 0)
+                break;
+
+            iteration = _mm_add_pd(iteration, _mm_and_pd(active, one));
+
+            __m128d xtemp = _mm_add_pd(_mm_sub_pd(xsqr, ysqr), x0);
+            y = _mm_add_pd(_mm_mul_pd(_mm_add_pd(x, x), y), y0);
+            x = xtemp;
+
+            // Les voies encore actives arrivent au maximum: leur état est gardé pour une reprise
+            if (step == task->max_iteration) {
+                keptX = _mm_or_pd(_mm_andnot_pd(active, keptX), _mm_and_pd(active, x));
+                keptY = _mm_or_pd(_mm_andnot_pd(active, keptY), _mm_and_pd(active, y));
+            }
+
+            if (checkPeriodicity) {
+                __m128d dx = _mm_andnot_pd(signBit, _mm_sub_pd(x, checkX));
+                __m128d dy = _mm_andnot_pd(signBit, _mm_sub_pd(y, checkY));
+                __m128d periodic = _mm_and_pd(active, _mm_and_pd(_mm_cmplt_pd(dx, tolerance), _mm_cmplt_pd(dy, tolerance)));
+
+                int periodicMask = _mm_movemask_pd(periodic);
+                if (periodicMask) {
+                    double laneIteration[2];
+                    _mm_storeu_pd(laneIteration, iteration);
+                    count_saved_iterations(ctx, laneIteration, periodicMask, task->max_iteration);
+
+                    iteration = _mm_or_pd(_mm_andnot_pd(periodic, iteration), _mm_and_pd(periodic, maxIteration));
+                    active = _mm_andnot_pd(periodic, active);
+                }
+
+                // Les voies actives ont toutes fait step itérations, le point gardé change en même temps
+                if (periodicity_checkpoint(step)) {
+                    checkX = x;
+                    checkY = y;
+                }
+            }
+        }
+
+        checkPeriodicity = _mm_movemask_pd(_mm_and_pd(valid, _mm_cmpeq_pd(iteration, maxIteration))) != 0;
+
+        // Seulement si une voie est au maximum, NaN pour celles qui ne s'échapperont jamais
+        // L'état des voies échappées n'est jamais relu
+        if (task->resumeX && checkPeriodicity) {
+            double laneX[2], laneY[2];
+            _mm_storeu_pd(laneX, keptX);
+            _mm_storeu_pd(laneY, keptY);
+            keep_lanes(task, py * w + px, laneX, laneY, lanes);
+        }
+
+        if (lanes == 2) {
+            _mm_storel_epi64((__m128i*)(row + px), _mm_cvttpd_epi32(iteration));
+        } else {
+            row[px] = (int)_mm_cvtsd_f64(iteration);
+        }
+    }
+
+    ctx->checkPeriodicity = checkPeriodicity;
+}
+
+// 4 pixels à la fois avec AVX2
+__attribute__((target("avx2")))
+void calculate_iterations_avx2(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) {
+    int w = task->width;
+    int h = task->height;
+    int *row = task->iterationMap + py * w;
+
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d maxIteration = _mm256_set1_pd((double)task->max_iteration);
+    const __m256d halfW = _mm256_set1_pd(w / 2.0);
+    const __m256d zoom = _mm256_set1_pd(task->zoom);
+    const __m256d offsetX = _mm256_set1_pd(task->offsetX);
+    const __m256d y0 = _mm256_set1_pd((py - h / 2.0) / task->zoom + task->offsetY);
+    const __m256d laneIndex = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    const __m256d tolerance = _mm256_set1_pd(PERIODICITY_TOLERANCE);
+
+    // Périodicité vérifiée seulement si le groupe précédent avait un pixel qui n'a pas pu s'échapper
+    bool checkPeriodicity = ctx->checkPeriodicity;
+
+    for (int px = xStart; px < xEnd; px += 4) {
+        int lanes = smallest(4, xEnd - px);
+
+        __m256d pxLanes = _mm256_add_pd(_mm256_set1_pd((double)px), laneIndex);
+        __m256d x0 = _mm256_add_pd(_mm256_div_pd(_mm256_sub_pd(pxLanes, halfW), zoom), offsetX);
+
+        // Les voies au-delà de la fin de la portion sont inactives dès le départ
+        __m256d valid = _mm256_cmp_pd(laneIndex, _mm256_set1_pd((double)lanes), _CMP_LT_OQ);
+        __m256d active = valid;
+
+        __m256d x = _mm256_setzero_pd();
+        __m256d y = _mm256_setzero_pd();
+        __m256d checkX = _mm256_setzero_pd();
+        __m256d checkY = _mm256_setzero_pd();
+        __m256d keptX = _mm256_set1_pd(NAN);
+        __m256d keptY = _mm256_set1_pd(NAN);
+
+        // Les pixels de l'intérieur connu partent directement au maximum, leur voie est donc inactive
+        __m256d iteration = _mm256_and_pd(interior_avx2(x0, y0), maxIteration);
+
+        for (int step = 1; ; step++) {
+            __m256d xsqr = _mm256_mul_pd(x, x);
+            __m256d ysqr = _mm256_mul_pd(y, y);
+
+            active = _mm256_and_pd(active, _mm256_cmp_pd(_mm256_add_pd(xsqr, ysqr), four, _CMP_LE_OQ));
+            active = _mm256_and_pd(active, _mm256_cmp_pd(iteration, maxIteration, _CMP_LT_OQ));
+            if (_mm256_movemask_pd(active) == 0)
+                break;
+
+            iteration = _mm256_add_pd(iteration, _mm256_and_pd(active, one));
+
+            __m256d xtemp = _mm256_add_pd(_mm256_sub_pd(xsqr, ysqr), x0);
+            y = _mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(x, x), y), y0);
+            x = xtemp;
+
+            // Les voies encore actives arrivent au maximum: leur état est gardé pour une reprise
+            if (step == task->max_iteration) {
+                keptX = _mm256_blendv_pd(keptX, x, active);
+                keptY = _mm256_blendv_pd(keptY, y, active);
+            }
+
+            if (checkPeriodicity) {
+                __m256d dx = _mm256_andnot_pd(signBit, _mm256_sub_pd(x, checkX));
+                __m256d dy = _mm256_andnot_pd(signBit, _mm256_sub_pd(y, checkY));
+                __m256d periodic = _mm256_and_pd(active, _mm256_and_pd(_mm256_cmp_pd(dx, tolerance, _CMP_LT_OQ),
+                                                                       _mm256_cmp_pd(dy, tolerance, _CMP_LT_OQ)));
+
+                int periodicMask = _mm256_movemask_pd(periodic);
+                if (periodicMask) {
+                    double laneIteration[4];
+                    _mm256_storeu_pd(laneIteration, iteration);
+                    count_saved_iterations(ctx, laneIteration, periodicMask, task->max_iteration);
+
+                    iteration = _mm256_blendv_pd(iteration, maxIteration, periodic);
+                    active = _mm256_andnot_pd(periodic, active);
+                }
+
+                // Les voies actives ont toutes fait step itérations, le point gardé change en même temps
+                if (periodicity_checkpoint(step)) {
+                    checkX = x;
+                    checkY = y;
+                }
+            }
+        }
+
+        checkPeriodicity = _mm256_movemask_pd(_mm256_and_pd(valid, _mm256_cmp_pd(iteration, maxIteration, _CMP_EQ_OQ))) != 0;
+
+        // Seulement si une voie est au maximum, NaN pour celles qui ne s'échapperont jamais
+        // L'état des voies échappées n'est jamais relu
+        if (task->resumeX && checkPeriodicity) {
+            double laneX[4], laneY[4];
+            _mm256_storeu_pd(laneX, keptX);
+            _mm256_storeu_pd(laneY, keptY);
+            keep_lanes(task, py * w + px, laneX, laneY, lanes);
+        }
+
+        if (lanes == 4) {
+            _mm_storeu_si128((__m128i*)(row + px), _mm256_cvttpd_epi32(iteration));
+        } else {
+            double result[4];
+            _mm256_storeu_pd(result, iteration);
+            for (int lane = 0; lane < lanes; lane++) {
+                row[px + lane] = (int)result[lane];
+            }
+        }
+    }
+
+    ctx->checkPeriodicity = checkPeriodicity;
+}
+
+// 8 pixels à la fois avec AVX-512, les voies actives sont un masque de bits
+__attribute__((target("avx512f")))
+void calculate_iterations_avx512(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) {
+    int w = task->width;
+    int h = task->height;
+    int *row = task->iterationMap + py * w;
+
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d maxIteration = _mm512_set1_pd((double)task->max_iteration);
+    const __m512d halfW = _mm512_set1_pd(w / 2.0);
+    const __m512d zoom = _mm512_set1_pd(task->zoom);
+    const __m512d offsetX = _mm512_set1_pd(task->offsetX);
+    const __m512d y0 = _mm512_set1_pd((py - h / 2.0) / task->zoom + task->offsetY);
+    const __m512d laneIndex = _mm512_set_pd(7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.0);
+    const __m512d tolerance = _mm512_set1_pd(PERIODICITY_TOLERANCE);
+
+    // Périodicité vérifiée seulement si le groupe précédent avait un pixel qui n'a pas pu s'échapper
+    bool checkPeriodicity = ctx->checkPeriodicity;
+
+    for (int px = xStart; px < xEnd; px += 8) {
+        int lanes = smallest(8, xEnd - px);
+
+        __m512d pxLanes = _mm512_add_pd(_mm512_set1_pd((double)px), laneIndex);
+        __m512d x0 = _mm512_add_pd(_mm512_div_pd(_mm512_sub_pd(pxLanes, halfW), zoom), offsetX);
+
+        __mmask8 valid = (__mmask8)((1u << lanes) - 1);
+        __mmask8 active = valid;
+
+        __m512d x = _mm512_setzero_pd();
+        __m512d y = _mm512_setzero_pd();
+        __m512d checkX = _mm512_setzero_pd();
+        __m512d checkY = _mm512_setzero_pd();
+        __m512d keptX = _mm512_set1_pd(NAN);
+        __m512d keptY = _mm512_set1_pd(NAN);
+
+        // Les pixels de l'intérieur connu partent directement au maximum, leur voie est donc inactive
+        __m512d iteration = _mm512_maskz_mov_pd(interior_avx512(x0, y0), maxIteration);
+
+        for (int step = 1; ; step++) {
+            __m512d xsqr = _mm512_mul_pd(x, x);
+            __m512d ysqr = _mm512_mul_pd(y, y);
+
+            active = _mm512_mask_cmp_pd_mask(active, _mm512_add_pd(xsqr, ysqr), four, _CMP_LE_OQ);
+            active = _mm512_mask_cmp_pd_mask(active, iteration, maxIteration, _CMP_LT_OQ);
+            if (active == 0)
+                break;
+
+            iteration = _mm512_mask_add_pd(iteration, active, iteration, one);
+
+            __m512d xtemp = _mm512_add_pd(_mm512_sub_pd(xsqr, ysqr), x0);
+            y = _mm512_add_pd(_mm512_mul_pd(_mm512_add_pd(x, x), y), y0);
+            x = xtemp;
+
+            // Les voies encore actives arrivent au maximum: leur état est gardé pour une reprise
+            if (step == task->max_iteration) {
+                keptX = _mm512_mask_mov_pd(keptX, active, x);
+                keptY = _mm512_mask_mov_pd(keptY, active, y);
+            }
+
+            if (checkPeriodicity) {
+                __mmask8 periodic = _mm512_mask_cmp_pd_mask(active, _mm512_abs_pd(_mm512_sub_pd(x, checkX)), tolerance, _CMP_LT_OQ);
+                periodic = _mm512_mask_cmp_pd_mask(periodic, _mm512_abs_pd(_mm512_sub_pd(y, checkY)), tolerance, _CMP_LT_OQ);
+
+                if (periodic) {
+                    double laneIteration[8];
+                    _mm512_storeu_pd(laneIteration, iteration);
+                    count_saved_iterations(ctx, laneIteration, periodic, task->max_iteration);
+
+                    iteration = _mm512_mask_mov_pd(iteration, periodic, maxIteration);
+                    active &= ~periodic;
+                }
+
+                // Les voies actives ont toutes fait step itérations, le point gardé change en même temps
+                if (periodicity_checkpoint(step)) {
+                    checkX = x;
+                    checkY = y;
+                }
+            }
+        }
+
+        checkPeriodicity = _mm512_mask_cmp_pd_mask(valid, iteration, maxIteration, _CMP_EQ_OQ) != 0;
+
+        // Seulement si une voie est au maximum, NaN pour celles qui ne s'échapperont jamais
+        // L'état des voies échappées n'est jamais relu
+        if (task->resumeX && checkPeriodicity) {
+            double laneX[8], laneY[8];
+            _mm512_storeu_pd(laneX, keptX);
+            _mm512_storeu_pd(laneY, keptY);
+            keep_lanes(task, py * w + px, laneX, laneY, lanes);
+        }
+
+        if (lanes == 8) {
+            _mm256_storeu_si256((__m256i*)(row + px), _mm512_cvttpd_epi32(iteration));
+        } else {
+            double result[8];
+            _mm512_storeu_pd(result, iteration);
+            for (int lane = 0; lane < lanes; lane++) {
+                row[px + lane] = (int)result[lane];
+            }
+        }
+    }
+
+    ctx->checkPeriodicity = checkPeriodicity;
+}
+
+
+
+/*
+    Noyaux à remplissage continu des voies
+
+    Les noyaux précédents attendent que la voie la plus lente d'un groupe ait
+    fini avant de passer au groupe suivant, ce qui gaspille la plupart des voies
+    près du bord de l'ensemble. Ici, dès qu'une voie a fini son pixel, son
+    résultat est écrit et elle repart aussitôt sur le prochain pixel en attente
+    de la portion, chaque voie gardant son propre compteur d'itérations.
+
+    Chaque voie a aussi sa propre détection de périodicité, activée pour un
+    nouveau pixel seulement si le pixel précédent de la voie n'a pas pu s'échapper.
+
+    Comme chaque voie part de son propre compteur, la variante AVX2 sait aussi
+    reprendre les pixels arrêtés au maximum d'un calcul précédent depuis leur état.
+*/
+
+// Place dans la voie lane le prochain pixel de la portion à itérer, faux s'il n'en reste plus
+// En reprise, les pixels qui gardent leur résultat sont passés et les autres repartent de leur état
+__attribute__((target("avx2")))
+static bool stream_load_lane(const FractalTask *task, WorkerContext *ctx, int py, double y0Row, int *next, int xEnd, int lane,
+                             int *lanePixel, double *laneX0, double *laneX, double *laneY, double *laneIteration,
+                             double *laneCheckX, double *laneCheckY, double *laneCheckpoint) {
+    double x = 0.0, y = 0.0;
+    int iteration = 0;
+
+    while (*next < xEnd && task->resumeFrom > 0 && !resume_pixel(task, ctx, py * task->width + *next, &x, &y, &iteration)) {
+        (*next)++;
+    }
+    if (*next >= xEnd)
+        return false;
+
+    int px = (*next)++;
+    lanePixel[lane] = px;
+    laneX0[lane] = (px - task->width / 2.0) / task->zoom + task->offsetX;
+    laneX[lane] = laneCheckX[lane] = x;
+    laneY[lane] = laneCheckY[lane] = y;
+    laneIteration[lane] = iteration;
+
+    // Prochaine puissance de 2 du compteur de la voie, 1 pour un pixel qui part de zéro
+    laneCheckpoint[lane] = 1.0;
+    while (laneCheckpoint[lane] <= iteration) {
+        laneCheckpoint[lane] *= 2.0;
+    }
+
+    // L'état NaN gardera le pixel au maximum lors d'une reprise
+    if (iteration == 0 && in_main_cardioid_or_bulb(laneX0[lane], y0Row)) {
+        laneIteration[lane] = task->max_iteration;
+        laneX[lane] = laneY[lane] = NAN;
+    }
+    return true;
+}
+
+// 4 voies AVX2, les voies à remplacer passent par la mémoire
+__attribute__((target("avx2")))
+void calculate_iterations_stream_avx2(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) {
+    int w = task->width;
+    int h = task->height;
+    int *row = task->iterationMap + py * w;
+
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d maxIteration = _mm256_set1_pd((double)task->max_iteration);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    const __m256d tolerance = _mm256_set1_pd(PERIODICITY_TOLERANCE);
+    double y0Row = (py - h / 2.0) / task->zoom + task->offsetY;
+    const __m256d y0 = _mm256_set1_pd(y0Row);
+
+    double laneX0[4], laneX[4], laneY[4], laneIteration[4];
+    double laneCheckX[4], laneCheckY[4], laneCheckpoint[4];
+    int lanePixel[4];
+    int occupied = 0;
+    int checking = ctx->checkPeriodicity ? 0x0F : 0;
+    int next = xStart;
+
+    // Remplissage initial, les voies sans pixel restent inoccupées
+    for (int lane = 0; lane < 4; lane++) {
+        laneX[lane] = laneY[lane] = laneIteration[lane] = 0.0;
+        laneCheckX[lane] = laneCheckY[lane] = 0.0;
+        laneCheckpoint[lane] = 1.0;
+        laneX0[lane] = 0.0;
+        if (stream_load_lane(task, ctx, py, y0Row, &next, xEnd, lane, lanePixel, laneX0, laneX, laneY, laneIteration,
+                             laneCheckX, laneCheckY, laneCheckpoint))
+            occupied |= 1 << lane;
+    }
+
+    // Un pixel de l'intérieur connu part au maximum: sa voie est libérée au tour suivant
+    // Un pixel repris part de son état gardé
+    __m256d x0 = _mm256_loadu_pd(laneX0);
+    __m256d x = _mm256_loadu_pd(laneX);
+    __m256d y = _mm256_loadu_pd(laneY);
+    __m256d iteration = _mm256_loadu_pd(laneIteration);
+    __m256d checkX = _mm256_loadu_pd(laneCheckX);
+    __m256d checkY = _mm256_loadu_pd(laneCheckY);
+    __m256d checkpoint = _mm256_loadu_pd(laneCheckpoint);
+
+    while (occupied) {
+        __m256d xsqr = _mm256_mul_pd(x, x);
+        __m256d ysqr = _mm256_mul_pd(y, y);
+
+        // Même condition de sortie que le noyau scalaire, NaN compris
+        __m256d done = _mm256_or_pd(_mm256_cmp_pd(_mm256_add_pd(xsqr, ysqr), four, _CMP_NLE_UQ),
+                                    _mm256_cmp_pd(iteration, maxIteration, _CMP_NLT_UQ));
+        int doneMask = _mm256_movemask_pd(done) & occupied;
+
+        if (doneMask) {
+            _mm256_storeu_pd(laneX0, x0);
+            _mm256_storeu_pd(laneX, x);
+            _mm256_storeu_pd(laneY, y);
+            _mm256_storeu_pd(laneIteration, iteration);
+            _mm256_storeu_pd(laneCheckX, checkX);
+            _mm256_storeu_pd(laneCheckY, checkY);
+            _mm256_storeu_pd(laneCheckpoint, checkpoint);
+
+            for (int lane = 0; lane < 4; lane++) {
+                if (!(doneMask & (1 << lane)))
+                    continue;
+
+                row[lanePixel[lane]] = (int)laneIteration[lane];
+
+                if (laneIteration[lane] >= task->max_iteration) {
+                    checking |= 1 << lane;
+
+                    // Etat au maximum, NaN si le pixel ne s'échappera jamais
+                    if (task->resumeX) {
+                        task->resumeX[py * w + lanePixel[lane]] = laneX[lane];
+                        task->resumeY[py * w + lanePixel[lane]] = laneY[lane];
+                    }
+                } else {
+                    checking &= ~(1 << lane);
+                }
+
+                if (!stream_load_lane(task, ctx, py, y0Row, &next, xEnd, lane, lanePixel, laneX0, laneX, laneY, laneIteration,
+                                      laneCheckX, laneCheckY, laneCheckpoint))
+                    occupied &= ~(1 << lane);
+            }
+
+            x0 = _mm256_loadu_pd(laneX0);
+            x = _mm256_loadu_pd(laneX);
+            y = _mm256_loadu_pd(laneY);
+            iteration = _mm256_loadu_pd(laneIteration);
+            checkX = _mm256_loadu_pd(laneCheckX);
+            checkY = _mm256_loadu_pd(laneCheckY);
+            checkpoint = _mm256_loadu_pd(laneCheckpoint);
+            continue;
+        }
+
+        iteration = _mm256_add_pd(iteration, one);
+
+        __m256d xtemp = _mm256_add_pd(_mm256_sub_pd(xsqr, ysqr), x0);
+        y = _mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(x, x), y), y0);
+        x = xtemp;
+
+        if (checking & occupied) {
+            __m256d dx = _mm256_andnot_pd(signBit, _mm256_sub_pd(x, checkX));
+            __m256d dy = _mm256_andnot_pd(signBit, _mm256_sub_pd(y, checkY));
+            __m256d periodic = _mm256_and_pd(_mm256_cmp_pd(dx, tolerance, _CMP_LT_OQ), _mm256_cmp_pd(dy, tolerance, _CMP_LT_OQ));
+
+            // La voie repart au maximum et sera libérée au tour suivant, avec l'état NaN des pixels qui ne s'échappent pas
+            int periodicMask = _mm256_movemask_pd(periodic) & checking & occupied;
+            if (periodicMask) {
+                _mm256_storeu_pd(laneIteration, iteration);
+                _mm256_storeu_pd(laneX, x);
+                _mm256_storeu_pd(laneY, y);
+                count_saved_iterations(ctx, laneIteration, periodicMask, task->max_iteration);
+
+                for (int lane = 0; lane < 4; lane++) {
+                    if (periodicMask & (1 << lane)) {
+                        laneIteration[lane] = task->max_iteration;
+                        laneX[lane] = laneY[lane] = NAN;
+                    }
+                }
+                iteration = _mm256_loadu_pd(laneIteration);
+                x = _mm256_loadu_pd(laneX);
+                y = _mm256_loadu_pd(laneY);
+            }
+
+            // Chaque voie remplace son point gardé quand son propre compteur atteint une puissance de 2
+            __m256d save = _mm256_cmp_pd(iteration, checkpoint, _CMP_EQ_OQ);
+            checkX = _mm256_blendv_pd(checkX, x, save);
+            checkY = _mm256_blendv_pd(checkY, y, save);
+            checkpoint = _mm256_blendv_pd(checkpoint, _mm256_add_pd(checkpoint, checkpoint), save);
+        }
+    }
+
+    ctx->checkPeriodicity = checking != 0;
+}
+
+// 8 voies AVX-512, les voies sont remplacées dans les registres par expand et les résultats écrits par scatter
+__attribute__((target("avx512f")))
+void calculate_iterations_stream_avx512(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) {
+    int w = task->width;
+    int h = task->height;
+    int *row = task->iterationMap + py * w;
+
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d maxIteration = _mm512_set1_pd((double)task->max_iteration);
+    const __m512d halfW = _mm512_set1_pd(w / 2.0);
+    const __m512d zoom = _mm512_set1_pd(task->zoom);
+    const __m512d offsetX = _mm512_set1_pd(task->offsetX);
+    const __m512d y0 = _mm512_set1_pd((py - h / 2.0) / task->zoom + task->offsetY);
+    const __m512d laneIndex = _mm512_set_pd(7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.0);
+    const __m512i laneIndexInt = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+    const __m512d tolerance = _mm512_set1_pd(PERIODICITY_TOLERANCE);
+
+    __m512d x0 = _mm512_setzero_pd();
+    __m512d x = _mm512_setzero_pd();
+    __m512d y = _mm512_setzero_pd();
+    __m512d iteration = _mm512_setzero_pd();
+    __m512d checkX = _mm512_setzero_pd();
+    __m512d checkY = _mm512_setzero_pd();
+    __m512d checkpoint = _mm512_set1_pd(1.0);
+    __m512i pixel = _mm512_setzero_si512();
+
+    // Toutes les voies sont libres au départ
+    __mmask8 occupied = 0;
+    __mmask8 checking = ctx->checkPeriodicity ? 0xFF : 0;
+    __mmask8 doneMask = 0xFF;
+    int next = xStart;
+
+    while (true) {
+        if (doneMask) {
+            // Ecrit le résultat des voies qui ont fini
+            __mmask8 finished = doneMask & occupied;
+            if (finished) {
+                _mm512_mask_i64scatter_epi32(row, finished, pixel, _mm512_cvttpd_epi32(iteration), 4);
+
+                __mmask8 capped = _mm512_mask_cmp_pd_mask(finished, iteration, maxIteration, _CMP_NLT_UQ);
+                checking = (checking & ~finished) | capped;
+
+                // Etat au maximum, NaN si le pixel ne s'échappera jamais
+                if (task->resumeX && capped) {
+                    _mm512_mask_i64scatter_pd(task->resumeX + py * w, capped, pixel, x, 8);
+                    _mm512_mask_i64scatter_pd(task->resumeY + py * w, capped, pixel, y, 8);
+                }
+            }
+
+            // Les prochains pixels de la portion vont dans les premières voies libérées
+            int pending = xEnd - next;
+            __mmask8 refill = 0;
+            __mmask8 free = doneMask;
+            for (int i = 0; i < pending && free; i++) {
+                refill |= free & -free;
+                free &= free - 1;
+            }
+
+            __m512d pxLanes = _mm512_add_pd(_mm512_set1_pd((double)next), laneIndex);
+            __m512d newX0 = _mm512_add_pd(_mm512_div_pd(_mm512_sub_pd(pxLanes, halfW), zoom), offsetX);
+            __m512i newPixel = _mm512_add_epi64(_mm512_set1_epi64(next), laneIndexInt);
+
+            x0 = _mm512_mask_expand_pd(x0, refill, newX0);
+            pixel = _mm512_mask_expand_epi64(pixel, refill, newPixel);
+            x = _mm512_mask_mov_pd(x, refill, _mm512_setzero_pd());
+            y = _mm512_mask_mov_pd(y, refill, _mm512_setzero_pd());
+            iteration = _mm512_mask_mov_pd(iteration, refill, _mm512_setzero_pd());
+            checkX = _mm512_mask_mov_pd(checkX, refill, _mm512_setzero_pd());
+            checkY = _mm512_mask_mov_pd(checkY, refill, _mm512_setzero_pd());
+            checkpoint = _mm512_mask_mov_pd(checkpoint, refill, one);
+
+            // Un pixel de l'intérieur connu part au maximum: sa voie est libérée au tour suivant, avec l'état NaN
+            __mmask8 interior = refill & interior_avx512(x0, y0);
+            iteration = _mm512_mask_mov_pd(iteration, interior, maxIteration);
+            x = _mm512_mask_mov_pd(x, interior, _mm512_set1_pd(NAN));
+            y = _mm512_mask_mov_pd(y, interior, _mm512_set1_pd(NAN));
+
+            next += __builtin_popcount(refill);
+            occupied = (occupied & ~doneMask) | refill;
+            if (!occupied)
+                break;
+        }
+
+        __m512d xsqr = _mm512_mul_pd(x, x);
+        __m512d ysqr = _mm512_mul_pd(y, y);
+
+        doneMask = _mm512_cmp_pd_mask(_mm512_add_pd(xsqr, ysqr), four, _CMP_NLE_UQ)
+                 | _mm512_cmp_pd_mask(iteration, maxIteration, _CMP_NLT_UQ);
+        doneMask &= occupied;
+        if (doneMask)
+            continue;
+
+        iteration = _mm512_add_pd(iteration, one);
+
+        __m512d xtemp = _mm512_add_pd(_mm512_sub_pd(xsqr, ysqr), x0);
+        y = _mm512_add_pd(_mm512_mul_pd(_mm512_add_pd(x, x), y), y0);
+        x = xtemp;
+
+        __mmask8 checked = checking & occupied;
+        if (checked) {
+            __mmask8 periodic = _mm512_mask_cmp_pd_mask(checked, _mm512_abs_pd(_mm512_sub_pd(x, checkX)), tolerance, _CMP_LT_OQ);
+            periodic = _mm512_mask_cmp_pd_mask(periodic, _mm512_abs_pd(_mm512_sub_pd(y, checkY)), tolerance, _CMP_LT_OQ);
+
+            // La voie repart au maximum et sera libérée au tour suivant, avec l'état NaN des pixels qui ne s'échappent pas
+            if (periodic) {
+                double laneIteration[8];
+                _mm512_storeu_pd(laneIteration, iteration);
+                count_saved_iterations(ctx, laneIteration, periodic, task->max_iteration);
+
+                iteration = _mm512_mask_mov_pd(iteration, periodic, maxIteration);
+                x = _mm512_mask_mov_pd(x, periodic, _mm512_set1_pd(NAN));
+                y = _mm512_mask_mov_pd(y, periodic, _mm512_set1_pd(NAN));
+            }
+
+            // Chaque voie remplace son point gardé quand son propre compteur atteint une puissance de 2
+            __mmask8 save = _mm512_mask_cmp_pd_mask(checked, iteration, checkpoint, _CMP_EQ_OQ);
+            checkX = _mm512_mask_mov_pd(checkX, save, x);
+            checkY = _mm512_mask_mov_pd(checkY, save, y);
+            checkpoint = _mm512_mask_add_pd(checkpoint, save, checkpoint, checkpoint);
+        }
+    }
+
+    ctx->checkPeriodicity = checking != 0;
+}
+
+#endif
@@ -0,0 +1,292 @@
+/*
+
+    Recherche de noyaux pour les zooms profonds
+
+    Période: on itère une boule de centre Z_n et de rayon R_n qui contient
+    les z_n de tous les c du disque de départ:
+        Z_n+1 = Z_n² + C,  R_n+1 = R_n (2 |Z_n| + R_n) + r
+    La première itération où la boule contient 0 donne la plus petite période
+    d'un noyau du disque.
+
+    Newton: avec z_p(c) l'orbite de 0 après p itérations et sa dérivée
+        dz_n+1 = 2 z_n dz_n + 1
+    on remplace c par c - z_p / dz_p jusqu'à ce que le pas soit négligeable
+    devant la taille d'un pixel.
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Seulement pour la version linux
+#ifdef __linux__
+    #include <mpfr.h>
+    #include <gmp.h>
+#endif
+
+#include "nucleus.h"
+#include "kernels.h"
+
+
+#ifdef __linux__
+
+    // Module d'un complexe MPFR en floatexp
+    static floatexp complex_abs(mpfr_srcptr x, mpfr_srcptr y) {
+        floatexp fx = fe_from_mpfr(x);
+        floatexp fy = fe_from_mpfr(y);
+        return fe_sqrt(fe_add(fe_mul(fx, fx), fe_mul(fy, fy)));
+    }
+
+    int nucleus_period(mpfr_srcptr cx, mpfr_srcptr cy, floatexp radius, int maxPeriod) {
+        mpfr_t x, y, xsqr, ysqr, xtemp;
+        mpfr_inits2(largest(mpfr_get_prec(cx), mpfr_get_prec(cy)), x, y, xsqr, ysqr, xtemp, (mpfr_ptr) 0);
+        mpfr_set(x, cx, MPFR_RNDN);
+        mpfr_set(y, cy, MPFR_RNDN);
+
+        // Z_1 = C, R_1 = r
+        floatexp r = radius;
+        const floatexp two = fe_from_double(2.0);
+        int period = 0;
+
+        for (int n = 1; n <= maxPeriod; n++) {
+            floatexp zAbs = complex_abs(x, y);
+
+            if (fe_less(zAbs, r)) {
+                period = n;
+                break;
+            }
+
+            // Toute la boule est sortie du disque de rayon 2: aucun noyau plus loin
+            if (fe_less(fe_add(two, r), zAbs))
+                break;
+
+            r = fe_add(fe_mul(r, fe_add(fe_ldexp(zAbs, 1), r)), radius);
+
+            mpfr_sqr(xsqr, x, MPFR_RNDN);
+            mpfr_sqr(ysqr, y, MPFR_RNDN);
+            mpfr_sub(xtemp, xsqr, ysqr, MPFR_RNDN);
+            mpfr_add(xtemp, xtemp, cx, MPFR_RNDN);
+
+            mpfr_mul(y, x, y, MPFR_RNDN);
+            mpfr_mul_2ui(y, y, 1, MPFR_RNDN);
+            mpfr_add(y, y, cy, MPFR_RNDN);
+
+            mpfr_set(x, xtemp, MPFR_RNDN);
+        }
+
+        mpfr_clears(x, y, xsqr, ysqr, xtemp, (mpfr_ptr) 0);
+        return period;
+    }
+
+    bool nucleus_newton(mpfr_ptr x, mpfr_ptr y, int period, floatexp tolerance, floatexp maxDistance) {
+        mpfr_prec_t precision = largest(mpfr_get_prec(x), mpfr_get_prec(y));
+
+        mpfr_t zx, zy, dx, dy, t1, t2, den, startX, startY;
+        mpfr_inits2(precision, zx, zy, dx, dy, t1, t2, den, startX, startY, (mpfr_ptr) 0);
+        mpfr_set(startX, x, MPFR_RNDN);
+        mpfr_set(startY, y, MPFR_RNDN);
+
+        bool converged = false;
+        for (int step = 0; step < NUCLEUS_NEWTON_STEPS && !converged; step++) {
+            mpfr_set_zero(zx, 1);
+            mpfr_set_zero(zy, 1);
+            mpfr_set_zero(dx, 1);
+            mpfr_set_zero(dy, 1);
+
+            for (int n = 0; n < period; n++) {
+                // dz = 2 z dz + 1, avec le z d'avant
+                mpfr_mul(t1, zx, dx, MPFR_RNDN);
+                mpfr_mul(t2, zy, dy, MPFR_RNDN);
+                mpfr_sub(t1, t1, t2, MPFR_RNDN);
+                mpfr_mul(t2, zx, dy, MPFR_RNDN);
+                mpfr_mul(dy, zy, dx, MPFR_RNDN);
+                mpfr_add(dy, dy, t2, MPFR_RNDN);
+                mpfr_mul_2ui(dy, dy, 1, MPFR_RNDN);
+                mpfr_mul_2ui(dx, t1, 1, MPFR_RNDN);
+                mpfr_add_ui(dx, dx, 1, MPFR_RNDN);
+
+                // z = z² + c
+                mpfr_sqr(t1, zx, MPFR_RNDN);
+                mpfr_sqr(t2, zy, MPFR_RNDN);
+                mpfr_sub(t1, t1, t2, MPFR_RNDN);
+                mpfr_add(t1, t1, x, MPFR_RNDN);
+                mpfr_mul(zy, zx, zy, MPFR_RNDN);
+                mpfr_mul_2ui(zy, zy, 1, MPFR_RNDN);
+                mpfr_add(zy, zy, y, MPFR_RNDN);
+                mpfr_set(zx, t1, MPFR_RNDN);
+            }
+
+            // Pas z / dz = z conj(dz) / |dz|²
+            mpfr_sqr(den, dx, MPFR_RNDN);
+            mpfr_sqr(t1, dy, MPFR_RNDN);
+            mpfr_add(den, den, t1, MPFR_RNDN);
+            if (mpfr_zero_p(den) || !mpfr_number_p(den))
+                break;
+
+            mpfr_mul(t1, zx, dx, MPFR_RNDN);
+            mpfr_mul(t2, zy, dy, MPFR_RNDN);
+            mpfr_add(t1, t1, t2, MPFR_RNDN);
+            mpfr_div(t1, t1, den, MPFR_RNDN);
+
+            mpfr_mul(t2, zy, dx, MPFR_RNDN);
+            mpfr_mul(zy, zx, dy, MPFR_RNDN);
+            mpfr_sub(t2, t2, zy, MPFR_RNDN);
+            mpfr_div(t2, t2, den, MPFR_RNDN);
+
+            if (!mpfr_number_p(t1) || !mpfr_number_p(t2))
+                break;
+
+            mpfr_sub(x, x, t1, MPFR_RNDN);
+            mpfr_sub(y, y, t2, MPFR_RNDN);
+            converged = fe_less(complex_abs(t1, t2), tolerance);
+
+            // Newton part vers un autre noyau, loin de l'image
+            mpfr_sub(t1, x, startX, MPFR_RNDN);
+            mpfr_sub(t2, y, startY, MPFR_RNDN);
+            if (fe_less(maxDistance, complex_abs(t1, t2))) {
+                converged = false;
+                break;
+            }
+        }
+
+        mpfr_clears(zx, zy, dx, dy, t1, t2, den, startX, startY, (mpfr_ptr) 0);
+        return converged;
+    }
+
+    // Disque qui contient toute l'image
+    static floatexp image_radius(const FractalTask *task) {
+        return fe_mul_d(task->pixelSize, hypot(task->width, task->height) / 2.0);
+    }
+
+    bool nucleus_find(const FractalTask *task, mpfr_ptr x, mpfr_ptr y, int *period) {
+        floatexp radius = image_radius(task);
+
+        *period = nucleus_period(task->centerX, task->centerY, radius, task->max_iteration);
+        if (*period == 0)
+            return false;
+
+        // Au moins la précision du centre, pour que le départ de Newton soit le centre exact
+        mpfr_prec_t precision = largest(high_precision_bits(task), largest(mpfr_get_prec(task->centerX), mpfr_get_prec(task->centerY)));
+        mpfr_t nx, ny;
+        mpfr_inits2(precision, nx, ny, (mpfr_ptr) 0);
+        mpfr_set(nx, task->centerX, MPFR_RNDN);
+        mpfr_set(ny, task->centerY, MPFR_RNDN);
+
+        floatexp tolerance = fe_ldexp(task->pixelSize, -NUCLEUS_NEWTON_BITS);
+        bool found = nucleus_newton(nx, ny, *period, tolerance, fe_mul_d(radius, NUCLEUS_MAX_DISTANCE));
+        if (found) {
+            mpfr_set_prec(x, precision);
+            mpfr_set_prec(y, precision);
+            mpfr_set(x, nx, MPFR_RNDN);
+            mpfr_set(y, ny, MPFR_RNDN);
+        } else {
+            *period = 0;
+        }
+
+        mpfr_clears(nx, ny, (mpfr_ptr) 0);
+        return found;
+    }
+
+    void nucleus_search_init(NucleusSearch *search) {
+        search->valid = false;
+        search->hits = 0;
+        mpfr_inits2(53, search->centerX, search->centerY, search->x, search->y, (mpfr_ptr) 0);
+    }
+
+    void nucleus_search_free(NucleusSearch *search) {
+        mpfr_clears(search->centerX, search->centerY, search->x, search->y, (mpfr_ptr) 0);
+    }
+
+    // Distance entre (ax, ay) et (bx, by)
+    static floatexp distance(mpfr_srcptr ax, mpfr_srcptr ay, mpfr_srcptr bx, mpfr_srcptr by) {
+        mpfr_t dx, dy;
+        mpfr_init2(dx, largest(mpfr_get_prec(ax), mpfr_get_prec(bx)));
+        mpfr_init2(dy, largest(mpfr_get_prec(ay), mpfr_get_prec(by)));
+        mpfr_sub(dx, ax, bx, MPFR_RNDN);
+        mpfr_sub(dy, ay, by, MPFR_RNDN);
+        floatexp d = complex_abs(dx, dy);
+        mpfr_clears(dx, dy, (mpfr_ptr) 0);
+        return d;
+    }
+
+    // Reprend la dernière recherche pour task si son résultat vaut encore, false sinon
+    static bool nucleus_search_reuse(const FractalTask *task, NucleusSearch *search, mpfr_ptr x, mpfr_ptr y, int *period) {
+        floatexp radius = image_radius(task);
+        if (!search->valid || task->max_iteration > search->maxPeriod)
+            return false;
+        if (fe_less(search->radius, fe_add(distance(task->centerX, task->centerY, search->centerX, search->centerY), radius)))
+            return false;
+
+        *period = search->period;
+        if (*period == 0)
+            return true;
+
+        // Même critère que nucleus_find: un noyau trop loin de la nouvelle image n'est plus une bonne référence
+        floatexp maxDistance = fe_mul_d(radius, NUCLEUS_MAX_DISTANCE);
+        if (fe_less(maxDistance, distance(task->centerX, task->centerY, search->x, search->y)))
+            return false;
+
+        // Pixels plus petits que la précision du noyau: Newton repart du noyau gardé, déjà tout près
+        floatexp tolerance = fe_ldexp(task->pixelSize, -NUCLEUS_NEWTON_BITS);
+        if (fe_less(tolerance, search->tolerance)) {
+            mpfr_prec_t precision = largest(high_precision_bits(task), largest(mpfr_get_prec(task->centerX), mpfr_get_prec(task->centerY)));
+            mpfr_prec_round(search->x, largest(precision, mpfr_get_prec(search->x)), MPFR_RNDN);
+            mpfr_prec_round(search->y, largest(precision, mpfr_get_prec(search->y)), MPFR_RNDN);
+            if (!nucleus_newton(search->x, search->y, *period, tolerance, maxDistance)) {
+                search->valid = false;
+                return false;
+            }
+            search->tolerance = tolerance;
+        }
+
+        mpfr_set_prec(x, mpfr_get_prec(search->x));
+        mpfr_set_prec(y, mpfr_get_prec(search->y));
+        mpfr_set(x, search->x, MPFR_RNDN);
+        mpfr_set(y, search->y, MPFR_RNDN);
+        return true;
+    }
+
+    bool nucleus_find_cached(const FractalTask *task, NucleusSearch *search, mpfr_ptr x, mpfr_ptr y, int *period) {
+        if (nucleus_search_reuse(task, search, x, y, period)) {
+            search->hits++;
+            return *period > 0;
+        }
+
+        bool found = nucleus_find(task, x, y, period);
+
+        search->valid = true;
+        mpfr_set_prec(search->centerX, mpfr_get_prec(task->centerX));
+        mpfr_set_prec(search->centerY, mpfr_get_prec(task->centerY));
+        mpfr_set(search->centerX, task->centerX, MPFR_RNDN);
+        mpfr_set(search->centerY, task->centerY, MPFR_RNDN);
+        search->radius = image_radius(task);
+        search->maxPeriod = task->max_iteration;
+        search->period = *period;
+        if (found) {
+            mpfr_set_prec(search->x, mpfr_get_prec(x));
+            mpfr_set_prec(search->y, mpfr_get_prec(y));
+            mpfr_set(search->x, x, MPFR_RNDN);
+            mpfr_set(search->y, y, MPFR_RNDN);
+            search->tolerance = fe_ldexp(task->pixelSize, -NUCLEUS_NEWTON_BITS);
+        }
+        return found;
+    }
+
+    void nucleus_job_init(NucleusJob *job) {
+        memset(job, 0, sizeof(*job));
+        mpfr_inits2(53, job->task.centerX, job->task.centerY, job->x, job->y, (mpfr_ptr) 0);
+    }
+
+    void nucleus_job_free(NucleusJob *job) {
+        mpfr_clears(job->task.centerX, job->task.centerY, job->x, job->y, (mpfr_ptr) 0);
+    }
+
+    int nucleus_job_run(void *arg) {
+        NucleusJob *job = (NucleusJob*)arg;
+        job->found = nucleus_find(&job->task, job->x, job->y, &job->period);
+        SDL_AtomicSet(&job->done, 1);
+        return 0;
+    }
+
+#endif
@@ -0,0 +1,364 @@
+/*
+
+    Orbites de référence gardées sur le disque
+
+    Format d'un fichier, dans l'ordre des octets de la machine:
+        en-tête OrbitFileHeader
+        referenceX, referenceY, lastX, lastY en texte hexadécimal exact,
+        chacun "précision mantisse@exposant" terminé par \0
+        des zéros jusqu'à un multiple de 64 octets
+        zr[length] puis zi[length]
+    La somme de contrôle couvre tout le fichier, son propre champ compté à 0.
+
+    Les fichiers sont projetés en mémoire: l'en-tête et le point de chaque
+    fichier sont lus sans toucher aux points de l'orbite, qui ne sont lus
+    (somme de contrôle, puis copie) que pour le fichier retenu. Un fichier est
+    écrit sous un nom temporaire puis renommé, un fichier invalide est donc
+    abimé et supprimé, et un fichier temporaire oublié par une session
+    interrompue est supprimé avec la limite de taille. Sa date de modification, remise à jour à chaque
+    chargement, sert à retirer les moins récemment utilisés.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <SDL2/SDL.h>
+
+// Seulement pour la version linux
+#ifdef __linux__
+    #include <mpfr.h>
+    #include <gmp.h>
+    #include <dirent.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#include "orbit_store.h"
+
+#define ORBIT_STORE_MAGIC "FRORBIT"
+#define ORBIT_STORE_EXTENSION ".orbit"
+#define ORBIT_STORE_TEMP_EXTENSION ".orbit.tmp"
+
+// Alignement des points de l'orbite dans le fichier
+#define ORBIT_STORE_ALIGN 64
+
+#define CHECKSUM_SEED 0xcbf29ce484222325ULL
+#define CHECKSUM_PRIME 0x100000001b3ULL
+
+
+#ifdef __linux__
+
+    typedef struct {
+        char magic[8];
+        uint32_t version;
+        int32_t period;
+        int64_t precision;
+        int32_t length;
+        int32_t maxIteration;
+        uint32_t textBytes;     // Les quatre nombres en texte avec leurs \0, sans les zéros qui suivent
+        uint32_t reserved;
+        uint64_t checksum;
+    } OrbitFileHeader;
+
+    // Position de zr[0] dans le fichier
+    static size_t data_offset(uint32_t textBytes) {
+        size_t offset = sizeof(OrbitFileHeader) + textBytes;
+        return (offset + ORBIT_STORE_ALIGN - 1) / ORBIT_STORE_ALIGN * ORBIT_STORE_ALIGN;
+    }
+
+    // FNV-1a sur des mots de 64 bits, brassé à chaque mot: quelques ms pour des centaines de Mo
+    static uint64_t checksum_update(uint64_t hash, const void *data, size_t bytes) {
+        const unsigned char *p = data;
+        size_t i = 0;
+        for (; i + 8 <= bytes; i += 8) {
+            uint64_t word;
+            memcpy(&word, p + i, 8);
+            hash = (hash ^ word) * CHECKSUM_PRIME;
+            hash ^= hash >> 29;
+        }
+        for (; i < bytes; i++)
+            hash = (hash ^ p[i]) * CHECKSUM_PRIME;
+        return hash;
+    }
+
+    // Somme de contrôle d'un fichier, en morceaux: texte et zéros, puis zr, puis zi
+    static uint64_t file_checksum(const OrbitFileHeader *header, const void *text, const double *zr, const double *zi) {
+        OrbitFileHeader copy = *header;
+        copy.checksum = 0;
+        uint64_t hash = checksum_update(CHECKSUM_SEED, &copy, sizeof(copy));
+        hash = checksum_update(hash, text, data_offset(header->textBytes) - sizeof(copy));
+        hash = checksum_update(hash, zr, (size_t)header->length * sizeof(double));
+        return checksum_update(hash, zi, (size_t)header->length * sizeof(double));
+    }
+
+    // Nombre MPFR en texte exact: en base 16, mpfr_get_str donne tous les chiffres
+    static char *mpfr_to_text(mpfr_srcptr x) {
+        mpfr_exp_t exponent;
+        char *digits = mpfr_get_str(NULL, &exponent, 16, 0, x, MPFR_RNDN);
+        int negative = digits[0] == '-';
+
+        size_t size = strlen(digits) + 64;
+        char *text = malloc(size);
+        snprintf(text, size, "%ld %s0.%s@%ld", (long)mpfr_get_prec(x), negative ? "-" : "", digits + negative, (long)exponent);
+        mpfr_free_str(digits);
+        return text;
+    }
+
+    static bool mpfr_from_text(mpfr_ptr x, const char *text) {
+        char *end;
+        long precision = strtol(text, &end, 10);
+        if (end == text || *end != ' ' || precision < MPFR_PREC_MIN || precision > MPFR_PREC_MAX)
+            return false;
+
+        mpfr_set_prec(x, precision);
+        return mpfr_set_str(x, end + 1, 16, MPFR_RNDN) == 0;
+    }
+
+    static floatexp distance(mpfr_srcptr ax, mpfr_srcptr ay, mpfr_srcptr bx, mpfr_srcptr by) {
+        mpfr_t d;
+        mpfr_init2(d, largest(mpfr_get_prec(ax), mpfr_get_prec(bx)));
+        mpfr_sub(d, ax, bx, MPFR_RNDN);
+        floatexp dx = fe_from_mpfr(d);
+        mpfr_sub(d, ay, by, MPFR_RNDN);
+        floatexp dy = fe_from_mpfr(d);
+        mpfr_clear(d);
+        return fe_sqrt(fe_add(fe_mul(dx, dx), fe_mul(dy, dy)));
+    }
+
+    static bool has_extension(const char *name, const char *extension) {
+        size_t length = strlen(name);
+        size_t extensionLength = strlen(extension);
+        return length > extensionLength && strcmp(name + length - extensionLength, extension) == 0;
+    }
+
+    static bool is_orbit_file(const char *name) {
+        return has_extension(name, ORBIT_STORE_EXTENSION);
+    }
+
+    // Charge le fichier s'il convient, le supprime s'il est abimé
+    static bool load_file(const char *file, ReferenceOrbit *orbit, mpfr_srcptr x, mpfr_srcptr y, int period,
+                          mpfr_prec_t minPrecision, floatexp maxDistance) {
+        int fd = open(file, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        size_t size = info.st_size;
+        const unsigned char *bytes = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (bytes == MAP_FAILED)
+            return false;
+
+        mpfr_t values[4];
+        for (int k = 0; k < 4; k++)
+            mpfr_init2(values[k], 53);
+
+        const OrbitFileHeader *header = (const OrbitFileHeader*)bytes;
+        const char *text = (const char*)(bytes + sizeof(OrbitFileHeader));
+        bool corrupt = size < sizeof(OrbitFileHeader) || memcmp(header->magic, ORBIT_STORE_MAGIC, sizeof(header->magic)) != 0;
+        bool loaded = false;
+
+        // Fichier d'une autre version: ignoré, la limite de taille finira par le retirer
+        if (!corrupt && header->version == ORBIT_STORE_VERSION) {
+            corrupt = header->length < 1 || header->period < 0 || header->textBytes == 0
+                   || size != data_offset(header->textBytes) + 2 * (size_t)header->length * sizeof(double)
+                   || text[header->textBytes - 1] != '\0';
+
+            const char *value = text;
+            for (int k = 0; k < 4 && !corrupt; k++) {
+                corrupt = value >= text + header->textBytes || !mpfr_from_text(values[k], value);
+                value += strlen(value) + 1;
+            }
+
+            if (!corrupt && header->period == period && header->precision >= minPrecision
+                && !fe_less(maxDistance, distance(values[0], values[1], x, y))) {
+                const double *zr = (const double*)(bytes + data_offset(header->textBytes));
+                const double *zi = zr + header->length;
+
+                corrupt = file_checksum(header, text, zr, zi) != header->checksum;
+                if (!corrupt) {
+                    mpfr_swap(orbit->referenceX, values[0]);
+                    mpfr_swap(orbit->referenceY, values[1]);
+                    mpfr_swap(orbit->lastX, values[2]);
+                    mpfr_swap(orbit->lastY, values[3]);
+                    orbit->precision = header->precision;
+                    orbit->period = header->period;
+                    orbit->maxIteration = header->maxIteration;
+                    orbit->length = orbit->capacity = header->length;
+
+                    free(orbit->zr);
+                    free(orbit->zi);
+                    orbit->zr = malloc((size_t)orbit->length * sizeof(double));
+                    orbit->zi = malloc((size_t)orbit->length * sizeof(double));
+                    memcpy(orbit->zr, zr, (size_t)orbit->length * sizeof(double));
+                    memcpy(orbit->zi, zi, (size_t)orbit->length * sizeof(double));
+                    loaded = true;
+                }
+            }
+        }
+
+        for (int k = 0; k < 4; k++)
+            mpfr_clear(values[k]);
+        munmap((void*)bytes, size);
+
+        if (corrupt) {
+            SDL_Log("Orbite abimée supprimée : %s", file);
+            unlink(file);
+        }
+
+        // Date de modification à maintenant: le fichier devient le plus récemment utilisé
+        if (loaded)
+            utimensat(AT_FDCWD, file, NULL, 0);
+        return loaded;
+    }
+
+    // Supprime les fichiers temporaires oubliés, puis les fichiers les moins récemment utilisés tant que le dossier
+    // dépasse maxBytes
+    // Un fichier temporaire récent est peut-être en cours d'écriture par une autre session: il est laissé
+    static void trim_store(const char *path, int64_t maxBytes) {
+        DIR *dir = opendir(path);
+        if (!dir)
+            return;
+        struct dirent *entry;
+        while ((entry = readdir(dir))) {
+            if (!has_extension(entry->d_name, ORBIT_STORE_TEMP_EXTENSION))
+                continue;
+
+            char file[1024];
+            snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+            struct stat info;
+            if (stat(file, &info) == 0 && time(NULL) - info.st_mtim.tv_sec > ORBIT_STORE_STALE_SECONDS)
+                unlink(file);
+        }
+        closedir(dir);
+
+        while (true) {
+            DIR *dir = opendir(path);
+            if (!dir)
+                return;
+
+            int64_t total = 0;
+            char oldest[1024] = "";
+            struct timespec oldestTime = {0};
+            struct dirent *entry;
+            while ((entry = readdir(dir))) {
+                if (!is_orbit_file(entry->d_name))
+                    continue;
+
+                char file[1024];
+                snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+                struct stat info;
+                if (stat(file, &info) != 0)
+                    continue;
+
+                total += info.st_size;
+                if (!oldest[0] || info.st_mtim.tv_sec < oldestTime.tv_sec
+                    || (info.st_mtim.tv_sec == oldestTime.tv_sec && info.st_mtim.tv_nsec < oldestTime.tv_nsec)) {
+                    snprintf(oldest, sizeof(oldest), "%s", file);
+                    oldestTime = info.st_mtim;
+                }
+            }
+            closedir(dir);
+
+            if (total <= maxBytes || !oldest[0] || unlink(oldest) != 0)
+                return;
+        }
+    }
+
+    bool orbit_store_load(const char *path, ReferenceOrbit *orbit, mpfr_srcptr x, mpfr_srcptr y, int period,
+                          mpfr_prec_t minPrecision, floatexp maxDistance) {
+        DIR *dir = opendir(path);
+        if (!dir)
+            return false;
+
+        bool loaded = false;
+        struct dirent *entry;
+        while (!loaded && (entry = readdir(dir))) {
+            if (!is_orbit_file(entry->d_name))
+                continue;
+
+            char file[1024];
+            snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+            loaded = load_file(file, orbit, x, y, period, minPrecision, maxDistance);
+        }
+        closedir(dir);
+        return loaded;
+    }
+
+    bool orbit_store_save(const char *path, const ReferenceOrbit *orbit) {
+        if (orbit->length < 1)
+            return false;
+
+        // Le dossier existe peut-être déjà
+        mkdir(path, 0755);
+
+        char *values[4] = {
+            mpfr_to_text(orbit->referenceX), mpfr_to_text(orbit->referenceY),
+            mpfr_to_text(orbit->lastX), mpfr_to_text(orbit->lastY)
+        };
+
+        OrbitFileHeader header = {0};
+        memcpy(header.magic, ORBIT_STORE_MAGIC, sizeof(header.magic));
+        header.version = ORBIT_STORE_VERSION;
+        header.period = orbit->period;
+        header.precision = orbit->precision;
+        header.length = orbit->length;
+        header.maxIteration = orbit->maxIteration;
+        for (int k = 0; k < 4; k++)
+            header.textBytes += strlen(values[k]) + 1;
+
+        size_t textSize = data_offset(header.textBytes) - sizeof(header);
+        char *text = calloc(textSize, 1);
+        char *value = text;
+        for (int k = 0; k < 4; k++) {
+            size_t length = strlen(values[k]) + 1;
+            memcpy(value, values[k], length);
+            value += length;
+        }
+        header.checksum = file_checksum(&header, text, orbit->zr, orbit->zi);
+
+        // Nom tiré du point et de la période: l'orbite prolongée remplace l'ancienne
+        uint64_t name = checksum_update(CHECKSUM_SEED, values[0], strlen(values[0]));
+        name = checksum_update(name, values[1], strlen(values[1]));
+        name = checksum_update(name, &header.period, sizeof(header.period));
+
+        char file[1024], temp[1040];
+        snprintf(file, sizeof(file), "%s/%016llx%s", path, (unsigned long long)name, ORBIT_STORE_EXTENSION);
+        snprintf(temp, sizeof(temp), "%s.tmp", file);
+
+        bool saved = false;
+        FILE *out = fopen(temp, "wb");
+        if (out) {
+            size_t length = orbit->length;
+            saved = fwrite(&header, sizeof(header), 1, out) == 1
+                 && fwrite(text, textSize, 1, out) == 1
+                 && fwrite(orbit->zr, sizeof(double), length, out) == length
+                 && fwrite(orbit->zi, sizeof(double), length, out) == length;
+            saved = fclose(out) == 0 && saved;
+            saved = saved && rename(temp, file) == 0;
+            if (!saved)
+                unlink(temp);
+        }
+        if (!saved)
+            SDL_Log("Erreur écriture de l'orbite : %s", file);
+
+        free(text);
+        for (int k = 0; k < 4; k++)
+            free(values[k]);
+
+        if (saved)
+            trim_store(path, ORBIT_STORE_MAX_BYTES);
+        return saved;
+    }
+
+#endif
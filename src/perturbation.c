@@ -0,0 +1,1070 @@
+
+/*
+
+    Calcul par perturbation pour les zooms profonds
+
+    Avec Z_n l'orbite de référence de C et z_n = Z_n + d_n celle du pixel
+    c = C + dc, l'écart suit d_n+1 = 2 Z_n d_n + d_n² + dc. Les écarts restent
+    de l'ordre de la taille de l'image, la double précision suffit pour eux
+    même quand elle ne suffit plus à distinguer deux pixels voisins.
+    Au-delà d'un zoom de 1e289, dc et d sont multipliés par 2^-scale pour
+    rester dans la portée du double, le terme d² par 2^scale, et ramenés
+    autour de 1 quand ils grandissent jusqu'à ce que d y tienne sans échelle.
+
+    Référence sur un noyau: l'orbite d'un noyau de période p ne s'échappe
+    jamais et revient en 0 toutes les p itérations. Seuls ses points Z_0 à Z_p
+    sont calculés et gardés, quel que soit le nombre d'itérations: les pixels
+    les reparcourent en boucle, et l'orbite comme sa table BLA tiennent en
+    mémoire même à des millions d'itérations. Les pixels ajoutent à leur dc
+    l'écart entre le centre de la vue et le noyau.
+
+    Approximation par séries: tant que dc est petit, d_n est très proche de
+    A_n dc + B_n dc² + C_n dc³, avec des coefficients communs à tous les pixels:
+        A_n+1 = 2 Z_n A_n + 1
+        B_n+1 = 2 Z_n B_n + A_n²
+        C_n+1 = 2 Z_n C_n + 2 A_n B_n
+    On avance les coefficients en comparant la série à l'écart réellement itéré
+    de points de contrôle aux coins et au milieu des bords de l'image. La dernière
+    itération où la série est encore juste pour tous est donnée directement à
+    chaque pixel, qui n'itère qu'à partir de là.
+
+    Approximations bilinéaires (BLA): à chaque pas le pixel saute le plus long
+    bloc d'itérations de la table encore juste pour son écart. Quand son orbite
+    passe plus près de 0 que son écart, ou au bout de l'orbite de référence,
+    il repart du début de la référence avec d = z (rebasing): l'écart reste
+    petit et aucun pixel n'a besoin de finir en itération directe.
+    Si la table est étendue, les écarts sont des floatexp: seul leur arrondi en
+    double, nul quand ils sont minuscules, sert aux tests d'échappement et de
+    rebasing, qui ne concernent que des écarts de l'ordre de Z.
+
+    Glitchs: sans rebasing, quand |Z + d| devient très petit devant |Z|, l'écart
+    d n'a plus de chiffres justes et le pixel est marqué glitché, de même s'il
+    survit à l'orbite de référence. Une fois l'image calculée, chaque blob de
+    glitchs reçoit une référence secondaire en son milieu et seuls ses pixels
+    sont recalculés, jusqu'à ce qu'il n'en reste plus.
+
+    Pipeline: l'orbite est calculée en série, les pixels peuvent démarrer sans
+    l'attendre. extend_orbit publie le nombre de points écrits tous les
+    ORBIT_PUBLISH_STEP points (un seul écrivain, les pixels ne font que lire),
+    et un pixel qui rattrape la tête de l'orbite attend la publication
+    suivante. Les tableaux sont réservés jusqu'à max_iteration avant la
+    première publication et ne bougent plus avant l'image suivante.
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+
+// Seulement pour la version linux
+#ifdef __linux__
+    #include <mpfr.h>
+    #include <gmp.h>
+#endif
+
+#include "perturbation.h"
+#include "kernels.h"
+#include "nucleus.h"
+#include "orbit_store.h"
+
+// Erreur relative tolérée entre la série et l'écart itéré d'un point de contrôle
+#define SERIES_TOLERANCE 1e-13
+
+// Points de contrôle: coins et milieux des bords de l'image
+#define SERIES_PROBES 8
+
+// Au-delà, des écarts mis à l'échelle sont ramenés vers 1 et leur échelle grandit d'autant
+#define PERTURBATION_RESCALE_LIMIT 1e19
+
+
+#ifdef __linux__
+
+    void reference_orbit_init(ReferenceOrbit *orbit) {
+        memset(orbit, 0, sizeof(*orbit));
+        mpfr_inits2(53, orbit->referenceX, orbit->referenceY, orbit->lastX, orbit->lastY, (mpfr_ptr) 0);
+        for (int i = 0; i < ORBIT_CACHE_SIZE; i++) {
+            CachedOrbit *entry = &orbit->cache.entries[i];
+            mpfr_inits2(53, entry->referenceX, entry->referenceY, entry->lastX, entry->lastY, (mpfr_ptr) 0);
+        }
+        nucleus_search_init(&orbit->nucleusSearch);
+        orbit->publishLock = SDL_CreateMutex();
+        orbit->publishCond = SDL_CreateCond();
+    }
+
+    void reference_orbit_free(ReferenceOrbit *orbit) {
+        free(orbit->zr);
+        free(orbit->zi);
+        orbit->zr = orbit->zi = NULL;
+        orbit->length = orbit->capacity = 0;
+        bla_table_free(&orbit->bla);
+        mpfr_clears(orbit->referenceX, orbit->referenceY, orbit->lastX, orbit->lastY, (mpfr_ptr) 0);
+        for (int i = 0; i < ORBIT_CACHE_SIZE; i++) {
+            CachedOrbit *entry = &orbit->cache.entries[i];
+            free(entry->zr);
+            free(entry->zi);
+            mpfr_clears(entry->referenceX, entry->referenceY, entry->lastX, entry->lastY, (mpfr_ptr) 0);
+        }
+        nucleus_search_free(&orbit->nucleusSearch);
+        SDL_DestroyCond(orbit->publishCond);
+        SDL_DestroyMutex(orbit->publishLock);
+    }
+
+    // Publie les points Z_0 à Z_published-1 (et la fin de l'orbite avec complete) et réveille les pixels qui attendent
+    static void publish_orbit(ReferenceOrbit *orbit, int published, bool complete) {
+        SDL_LockMutex(orbit->publishLock);
+        SDL_AtomicSet(&orbit->published, published);
+        if (complete)
+            SDL_AtomicSet(&orbit->complete, 1);
+        SDL_CondBroadcast(orbit->publishCond);
+        SDL_UnlockMutex(orbit->publishLock);
+    }
+
+    // Précision de l'orbite: la même que celle du calcul MPFR direct
+    static mpfr_prec_t orbit_precision(const FractalTask *task) {
+        return high_precision_bits(task);
+    }
+
+    // Produit de deux complexes (réel, imaginaire)
+    static inline void complex_mul(double ar, double ai, double br, double bi, double *r, double *i) {
+        double re = ar * br - ai * bi;
+        *i = ar * bi + ai * br;
+        *r = re;
+    }
+
+    // Valeur de la série A dc + B dc² + C dc³, par la méthode de Horner
+    static inline void series_eval(const double *A, const double *B, const double *C, double dcx, double dcy, double *dx, double *dy) {
+        double r, i;
+        complex_mul(C[0], C[1], dcx, dcy, &r, &i);
+        complex_mul(r + B[0], i + B[1], dcx, dcy, &r, &i);
+        complex_mul(r + A[0], i + A[1], dcx, dcy, dx, dy);
+    }
+
+    // Echelle des écarts de la tâche: ils sont multipliés par 2^-scale pour rester dans la portée du double
+    // 0 tant que la taille d'un pixel y tient, au-delà (zooms après 1e289) scale suit son exposant
+    static int delta_scale(const FractalTask *task) {
+        return task->pixelSize.exponent < FLOATEXP_DOUBLE_MIN_EXP ? task->pixelSize.exponent : 0;
+    }
+
+    // dc d'une coordonnée à pixels pixels du centre, shift étant l'écart du centre à la référence, multiplié par 2^-scale
+    static double pixel_delta(const FractalTask *task, double pixels, floatexp shift, int scale) {
+        return fe_to_double(fe_ldexp(fe_add(fe_mul_d(task->pixelSize, pixels), shift), -scale));
+    }
+
+    // Ramène des écarts multipliés par 2^-scale vers 1, retourne leur nouvelle échelle
+    // Dès que l'écart tient dans le double, l'échelle revient à 0: dc s'arrondit alors peut-être à 0, mais il ne
+    // compte plus devant d
+    static int rescale_deltas(double *dx, double *dy, double *dcx, double *dcy, int scale) {
+        int k = ilogb(fabs(*dx) + fabs(*dy));
+        if (scale + k >= FLOATEXP_DOUBLE_MIN_EXP)
+            k = -scale;
+        *dx = ldexp(*dx, -k);
+        *dy = ldexp(*dy, -k);
+        *dcx = ldexp(*dcx, -k);
+        *dcy = ldexp(*dcy, -k);
+        return scale + k;
+    }
+
+    // Cherche le nombre d'itérations que la série permet de sauter et ses coefficients à cette itération
+    // Les points de contrôle suivent les écarts mis à l'échelle comme les pixels, chacun avec la sienne
+    static void compute_series_approximation(const FractalTask *task, ReferenceOrbit *orbit) {
+        double A[2] = {0.0, 0.0}, B[2] = {0.0, 0.0}, C[2] = {0.0, 0.0};
+
+        double probeX[SERIES_PROBES], probeY[SERIES_PROBES];
+        double probeDx[SERIES_PROBES], probeDy[SERIES_PROBES];
+        int probeScale[SERIES_PROBES];
+        int scale = delta_scale(task);
+        int probeCount = 0;
+        for (int j = 0; j < 3; j++) {
+            for (int i = 0; i < 3; i++) {
+                if (i == 1 && j == 1)
+                    continue;
+                int px = (task->width - 1) * i / 2;
+                int py = (task->height - 1) * j / 2;
+                probeX[probeCount] = pixel_delta(task, px - task->width / 2.0, orbit->shiftX, scale);
+                probeY[probeCount] = pixel_delta(task, py - task->height / 2.0, orbit->shiftY, scale);
+                probeDx[probeCount] = probeDy[probeCount] = 0.0;
+                probeScale[probeCount] = scale;
+                probeCount++;
+            }
+        }
+
+        int skip = 0;
+        int last = smallest(orbit->length - 1, task->max_iteration);
+
+        while (skip < last) {
+            double zr = orbit->zr[skip];
+            double zi = orbit->zi[skip];
+
+            // Coefficients à l'itération suivante
+            double nA[2], nB[2], nC[2], t[2];
+            complex_mul(2.0 * zr, 2.0 * zi, A[0], A[1], &nA[0], &nA[1]);
+            nA[0] += 1.0;
+            complex_mul(2.0 * zr, 2.0 * zi, B[0], B[1], &nB[0], &nB[1]);
+            complex_mul(A[0], A[1], A[0], A[1], &t[0], &t[1]);
+            nB[0] += t[0];
+            nB[1] += t[1];
+            complex_mul(2.0 * zr, 2.0 * zi, C[0], C[1], &nC[0], &nC[1]);
+            complex_mul(2.0 * A[0], 2.0 * A[1], B[0], B[1], &t[0], &t[1]);
+            nC[0] += t[0];
+            nC[1] += t[1];
+
+            bool valid = true;
+            for (int p = 0; p < probeCount && valid; p++) {
+                // Ecarts multipliés par 2^-probeScale[p]: d² devient S d², exact quand S = 1
+                double S = ldexp(1.0, probeScale[p]);
+                double dx = probeDx[p], dy = probeDy[p];
+                double dxtemp = 2.0 * (zr * dx - zi * dy) + S * (dx * dx - dy * dy) + probeX[p];
+                dy = 2.0 * (zr * dy + zi * dx) + S * 2.0 * dx * dy + probeY[p];
+                dx = dxtemp;
+                if (probeScale[p] < 0 && fabs(dx) + fabs(dy) > PERTURBATION_RESCALE_LIMIT) {
+                    probeScale[p] = rescale_deltas(&dx, &dy, &probeX[p], &probeY[p], probeScale[p]);
+                    S = ldexp(1.0, probeScale[p]);
+                }
+                probeDx[p] = dx;
+                probeDy[p] = dy;
+
+                // Un point de contrôle qui s'échappe arrête la série: les pixels doivent voir leur échappement
+                double x = orbit->zr[skip + 1] + S * dx;
+                double y = orbit->zi[skip + 1] + S * dy;
+                if (x * x + y * y > 4.0) {
+                    valid = false;
+                    break;
+                }
+
+                // Série à la même échelle: A dc' + S B dc'² + S² C dc'³
+                double sB[2] = { S * nB[0], S * nB[1] };
+                double sC[2] = { S * S * nC[0], S * S * nC[1] };
+                double sx, sy;
+                series_eval(nA, sB, sC, probeX[p], probeY[p], &sx, &sy);
+                double errorSqr = (sx - dx) * (sx - dx) + (sy - dy) * (sy - dy);
+                double normSqr = dx * dx + dy * dy;
+                if (!(errorSqr <= SERIES_TOLERANCE * SERIES_TOLERANCE * normSqr))
+                    valid = false;
+            }
+
+            if (!valid)
+                break;
+
+            A[0] = nA[0]; A[1] = nA[1];
+            B[0] = nB[0]; B[1] = nB[1];
+            C[0] = nC[0]; C[1] = nC[1];
+            skip++;
+        }
+
+        orbit->seriesSkip = skip;
+        for (int k = 0; k < 2; k++) {
+            orbit->seriesA[k] = A[k];
+            orbit->seriesB[k] = B[k];
+            orbit->seriesC[k] = C[k];
+        }
+    }
+
+    // Prolonge l'orbite de Z_length-1 (orbit->lastX, orbit->lastY) jusqu'à max_iteration ou l'échappement
+    // Sur un noyau, l'orbite s'arrête à Z_p: la suite répète la première période
+    // cancel est regardé à chaque publication: l'orbite s'arrête alors à un point d'où elle pourra repartir, retourne false
+    static bool extend_orbit(const FractalTask *task, ReferenceOrbit *orbit, const SDL_atomic_t *cancel) {
+        int maxIteration = task->max_iteration;
+        orbit->maxIteration = maxIteration;
+
+        int first = orbit->length - 1;
+        int n = first;
+
+        if (orbit->period > 0 && n >= orbit->period)
+            return true;
+
+        // Z_0 à Z_max_iteration au plus, réservés avant que des pixels ne lisent l'orbite
+        if (orbit->capacity < maxIteration + 1) {
+            orbit->capacity = maxIteration + 1;
+            orbit->zr = realloc(orbit->zr, orbit->capacity * sizeof(double));
+            orbit->zi = realloc(orbit->zi, orbit->capacity * sizeof(double));
+        }
+        publish_orbit(orbit, orbit->length, false);
+
+        mpfr_t cx, cy, xsqr, ysqr, xtemp;
+        mpfr_inits2(orbit->precision, cx, cy, xsqr, ysqr, xtemp, (mpfr_ptr) 0);
+        mpfr_ptr x = orbit->lastX;
+        mpfr_ptr y = orbit->lastY;
+
+        mpfr_set(cx, orbit->referenceX, MPFR_RNDN);
+        mpfr_set(cy, orbit->referenceY, MPFR_RNDN);
+
+        bool cancelled = false;
+        while (true) {
+            orbit->zr[n] = mpfr_get_d(x, MPFR_RNDN);
+            orbit->zi[n] = mpfr_get_d(y, MPFR_RNDN);
+
+            mpfr_sqr(xsqr, x, MPFR_RNDN);
+            mpfr_sqr(ysqr, y, MPFR_RNDN);
+            mpfr_add(xtemp, xsqr, ysqr, MPFR_RNDN);
+
+            // Le dernier point gardé est le premier en dehors du disque de rayon 2, ou Z_p sur un noyau
+            if (n == maxIteration || mpfr_cmp_d(xtemp, 4.0) > 0 || (orbit->period > 0 && n == orbit->period))
+                break;
+
+            // Abandon: Z_n est le dernier point, comme si l'orbite avait été demandée jusqu'à n
+            if ((n & (ORBIT_PUBLISH_STEP - 1)) == 0 && SDL_AtomicGet((SDL_atomic_t*)cancel)) {
+                orbit->maxIteration = n;
+                cancelled = true;
+                break;
+            }
+
+            mpfr_sub(xtemp, xsqr, ysqr, MPFR_RNDN);
+            mpfr_add(xtemp, xtemp, cx, MPFR_RNDN);
+
+            mpfr_mul(y, x, y, MPFR_RNDN);
+            mpfr_mul_2ui(y, y, 1, MPFR_RNDN);
+            mpfr_add(y, y, cy, MPFR_RNDN);
+
+            mpfr_set(x, xtemp, MPFR_RNDN);
+
+            n++;
+            if ((n & (ORBIT_PUBLISH_STEP - 1)) == 0)
+                publish_orbit(orbit, n, false);
+            if ((n & 1023) == 0)
+                *task->progress = (int)((int64_t)(n - first) * 100 / (maxIteration - first));
+        }
+
+        orbit->length = n + 1;
+        mpfr_clears(cx, cy, xsqr, ysqr, xtemp, (mpfr_ptr) 0);
+
+        publish_orbit(orbit, orbit->length, true);
+        return !cancelled;
+    }
+
+    // Une orbite échappée ou périodique ne sera plus prolongée: on rend la place réservée jusqu'à max_iteration
+    // Les tableaux peuvent changer d'adresse, aucun pixel ne doit lire l'orbite
+    static void shrink_orbit(ReferenceOrbit *orbit) {
+        if (orbit->length > 0 && orbit->capacity > orbit->length) {
+            orbit->capacity = orbit->length;
+            orbit->zr = realloc(orbit->zr, orbit->capacity * sizeof(double));
+            orbit->zi = realloc(orbit->zi, orbit->capacity * sizeof(double));
+        }
+    }
+
+    // Remet l'orbite à Z_0, à calculer à la précision donnée par extend_orbit
+    static void restart_orbit(ReferenceOrbit *orbit, mpfr_prec_t precision) {
+        orbit->precision = precision;
+        mpfr_set_prec(orbit->lastX, precision);
+        mpfr_set_prec(orbit->lastY, precision);
+        mpfr_set_zero(orbit->lastX, 1);
+        mpfr_set_zero(orbit->lastY, 1);
+        orbit->length = 1;
+        orbit->maxIteration = 0;
+    }
+
+    // Calcule depuis Z_0 l'orbite de orbit->referenceX, orbit->referenceY à la précision donnée
+    // Retourne false si cancel a arrêté le calcul
+    static bool compute_orbit(const FractalTask *task, ReferenceOrbit *orbit, mpfr_prec_t precision, const SDL_atomic_t *cancel) {
+        restart_orbit(orbit, precision);
+        return extend_orbit(task, orbit, cancel);
+    }
+
+    // Vrai si l'orbite de point (x, y), de période period, calculée à la précision donnée, sert pour le point voulu
+    static bool orbit_matches(mpfr_srcptr x, mpfr_srcptr y, int period, mpfr_prec_t precision, int length,
+                              mpfr_srcptr wantedX, mpfr_srcptr wantedY, int wantedPeriod, const FractalTask *task) {
+        if (length == 0 || period != wantedPeriod || precision < orbit_precision(task))
+            return false;
+
+        mpfr_t d;
+        mpfr_init2(d, largest(mpfr_get_prec(x), mpfr_get_prec(wantedX)));
+        mpfr_sub(d, x, wantedX, MPFR_RNDN);
+        floatexp dx = fe_from_mpfr(d);
+        mpfr_sub(d, y, wantedY, MPFR_RNDN);
+        floatexp dy = fe_from_mpfr(d);
+        mpfr_clear(d);
+
+        floatexp distance = fe_sqrt(fe_add(fe_mul(dx, dx), fe_mul(dy, dy)));
+        return !fe_less(fe_ldexp(task->pixelSize, -ORBIT_CACHE_MATCH_BITS), distance);
+    }
+
+    // Echange l'orbite courante et une orbite du cache
+    static void orbit_swap(ReferenceOrbit *orbit, CachedOrbit *entry) {
+        double *zr = orbit->zr, *zi = orbit->zi;
+        orbit->zr = entry->zr;
+        orbit->zi = entry->zi;
+        entry->zr = zr;
+        entry->zi = zi;
+
+        int length = orbit->length, capacity = orbit->capacity, maxIteration = orbit->maxIteration, period = orbit->period;
+        orbit->length = entry->length;
+        orbit->capacity = entry->capacity;
+        orbit->maxIteration = entry->maxIteration;
+        orbit->period = entry->period;
+        entry->length = length;
+        entry->capacity = capacity;
+        entry->maxIteration = maxIteration;
+        entry->period = period;
+
+        mpfr_prec_t precision = orbit->precision;
+        orbit->precision = entry->precision;
+        entry->precision = precision;
+
+        mpfr_swap(orbit->referenceX, entry->referenceX);
+        mpfr_swap(orbit->referenceY, entry->referenceY);
+        mpfr_swap(orbit->lastX, entry->lastX);
+        mpfr_swap(orbit->lastY, entry->lastY);
+    }
+
+    // Vide une entrée du cache
+    static void cache_evict(CachedOrbit *entry) {
+        free(entry->zr);
+        free(entry->zi);
+        entry->zr = entry->zi = NULL;
+        entry->length = entry->capacity = 0;
+    }
+
+    // Met l'orbite courante dans le cache à la place d'une entrée vide ou de la moins récemment utilisée
+    // L'orbite courante est ensuite vide, et le cache ne dépasse pas ORBIT_CACHE_MAX_BYTES
+    static void cache_store(ReferenceOrbit *orbit) {
+        OrbitCache *cache = &orbit->cache;
+
+        CachedOrbit *slot = &cache->entries[0];
+        for (int i = 0; i < ORBIT_CACHE_SIZE; i++) {
+            CachedOrbit *entry = &cache->entries[i];
+            if (entry->length == 0) {
+                slot = entry;
+                break;
+            }
+            if (entry->lastUse < slot->lastUse)
+                slot = entry;
+        }
+
+        cache_evict(slot);
+        orbit_swap(orbit, slot);
+        slot->lastUse = ++cache->clock;
+
+        while (true) {
+            size_t bytes = 0;
+            CachedOrbit *oldest = NULL;
+            for (int i = 0; i < ORBIT_CACHE_SIZE; i++) {
+                CachedOrbit *entry = &cache->entries[i];
+                if (entry->length == 0)
+                    continue;
+                bytes += (size_t)entry->capacity * 2 * sizeof(double);
+                if (!oldest || entry->lastUse < oldest->lastUse)
+                    oldest = entry;
+            }
+            if (bytes <= ORBIT_CACHE_MAX_BYTES || !oldest)
+                break;
+            cache_evict(oldest);
+        }
+    }
+
+    int compute_reference_orbit(void *arg) {
+        FractalTask *task = (FractalTask*)arg;
+        ReferenceOrbit *orbit = task->reference;
+
+        *task->progress = 0;
+        SDL_AtomicSet(&orbit->complete, 0);
+
+        // Plus aucun pixel ne lit l'orbite de l'image précédente, même calculée en pipeline
+        shrink_orbit(orbit);
+
+        // Point de référence voulu: le centre de la vue, ou le noyau de plus petite période près de l'image
+        mpfr_t wantedX, wantedY;
+        mpfr_init2(wantedX, mpfr_get_prec(task->centerX));
+        mpfr_init2(wantedY, mpfr_get_prec(task->centerY));
+        mpfr_set(wantedX, task->centerX, MPFR_RNDN);
+        mpfr_set(wantedY, task->centerY, MPFR_RNDN);
+        int wantedPeriod = 0;
+        if (task->nucleusReference)
+            nucleus_find_cached(task, &orbit->nucleusSearch, wantedX, wantedY, &wantedPeriod);
+
+        // L'orbite courante, ou à défaut une du cache ou du disque, si elle a été calculée au même point avec assez de précision
+        // Sinon elle repart de Z_0 au point voulu
+        bool changed = false;
+        if (!orbit_matches(orbit->referenceX, orbit->referenceY, orbit->period, orbit->precision, orbit->length,
+                           wantedX, wantedY, wantedPeriod, task)) {
+            CachedOrbit *hit = NULL;
+            for (int i = 0; i < ORBIT_CACHE_SIZE && !hit; i++) {
+                CachedOrbit *entry = &orbit->cache.entries[i];
+                if (orbit_matches(entry->referenceX, entry->referenceY, entry->period, entry->precision, entry->length,
+                                  wantedX, wantedY, wantedPeriod, task))
+                    hit = entry;
+            }
+
+            if (hit) {
+                // L'orbite courante prend la place de celle reprise
+                orbit_swap(orbit, hit);
+                hit->lastUse = ++orbit->cache.clock;
+                orbit->cache.hits++;
+            } else {
+                if (orbit->length > 0)
+                    cache_store(orbit);
+                if (!orbit_store_load(ORBIT_STORE_PATH, orbit, wantedX, wantedY, wantedPeriod, orbit_precision(task),
+                                      fe_ldexp(task->pixelSize, -ORBIT_CACHE_MATCH_BITS))) {
+                    mpfr_set_prec(orbit->referenceX, mpfr_get_prec(wantedX));
+                    mpfr_set_prec(orbit->referenceY, mpfr_get_prec(wantedY));
+                    mpfr_set(orbit->referenceX, wantedX, MPFR_RNDN);
+                    mpfr_set(orbit->referenceY, wantedY, MPFR_RNDN);
+                    orbit->period = wantedPeriod;
+                    restart_orbit(orbit, orbit_precision(task) + ORBIT_PRECISION_HEADROOM);
+                }
+            }
+            changed = true;
+        }
+
+        // Orbite nouvelle, ou plus d'itérations qu'au calcul et l'orbite ne s'était pas échappée: on la prolonge
+        bool extend = task->max_iteration > orbit->maxIteration && orbit->length - 1 == orbit->maxIteration;
+
+        // Ecart du centre à la référence, nul sans noyau
+        mpfr_t shift;
+        mpfr_init2(shift, largest(mpfr_get_prec(orbit->referenceX), mpfr_get_prec(task->centerX)));
+        mpfr_sub(shift, task->centerX, orbit->referenceX, MPFR_RNDN);
+        orbit->shiftX = fe_from_mpfr(shift);
+        mpfr_sub(shift, task->centerY, orbit->referenceY, MPFR_RNDN);
+        orbit->shiftY = fe_from_mpfr(shift);
+        mpfr_clears(shift, wantedX, wantedY, (mpfr_ptr) 0);
+
+        orbit->glitchedPixels = 0;
+        orbit->secondaryReferences = 0;
+        orbit->seriesSkip = 0;
+
+        // En pipeline, les pixels suivent l'orbite dès que extend_orbit en publie les premiers points
+        bool save = false;
+        if (extend) {
+            Uint64 start = SDL_GetPerformanceCounter();
+            bool done = extend_orbit(task, orbit, &orbit->cancel);
+            double elapsed = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+            changed = true;
+
+            // Calcul abandonné: l'orbite partielle reste pour l'image suivante, sans série ni table
+            if (!done) {
+                bla_table_free(&orbit->bla);
+                SDL_AtomicSet(&orbit->ready, 1);
+                return 0;
+            }
+
+            if (!task->pipelinedReference)
+                shrink_orbit(orbit);
+
+            // Une orbite longue à calculer sera gardée sur le disque pour les sessions suivantes
+            save = elapsed >= ORBIT_STORE_MIN_MS;
+        }
+        orbit->maxIteration = largest(orbit->maxIteration, task->max_iteration);
+
+        if (changed)
+            bla_table_free(&orbit->bla);
+
+        // Les pixels lancés pendant le calcul de l'orbite sont partis sans série
+        if (task->seriesApproximation && !(extend && task->pipelinedReference))
+            compute_series_approximation(task, orbit);
+
+        // Les rayons de la table restent justes pour un |dc| plus petit, donc en zoomant sur la même orbite
+        if (task->bilinearApproximation) {
+            floatexp shift = fe_sqrt(fe_add(fe_mul(orbit->shiftX, orbit->shiftX), fe_mul(orbit->shiftY, orbit->shiftY)));
+            floatexp dcMax = fe_add(fe_mul_d(task->pixelSize, hypot(task->width / 2.0, task->height / 2.0)), shift);
+            bool extended = dcMax.exponent < FLOATEXP_DOUBLE_MIN_EXP;
+            if (orbit->bla.levels == 0 || fe_less(orbit->bla.dcMax, dcMax) || extended != orbit->bla.extended)
+                bla_table_build(&orbit->bla, orbit, dcMax, SDL_GetCPUCount());
+        }
+
+        // Orbite reprise sans calcul: les pixels en pipeline l'attendaient complète
+        publish_orbit(orbit, orbit->length, true);
+
+        SDL_AtomicSet(&orbit->ready, 1);
+
+        // Ecrite après ready: l'image n'attend pas le disque, les pixels ne font que lire l'orbite pendant l'écriture
+        // Le thread doit être attendu avant que l'orbite ne soit recalculée ou libérée
+        if (save)
+            orbit_store_save(ORBIT_STORE_PATH, orbit);
+        return 0;
+    }
+
+    void reference_orbit_cancel(ReferenceOrbit *orbit) {
+        SDL_LockMutex(orbit->publishLock);
+        SDL_AtomicSet(&orbit->cancel, 1);
+        SDL_CondBroadcast(orbit->publishCond);
+        SDL_UnlockMutex(orbit->publishLock);
+    }
+
+    // Attend que l'orbite ait au moins count points publiés, soit complète ou abandonnée, retourne le nombre de points publiés
+    // Un complete resté de l'image précédente ne compte pas tant que published n'est pas repassé au-dessus de 0
+    // poolCancel (NULL hors du pool) n'est pas signalé par l'orbite: il est relu toutes les ORBIT_WAIT_TIMEOUT_MS
+    static int wait_orbit(const ReferenceOrbit *orbit, int count, SDL_atomic_t *poolCancel) {
+        SDL_atomic_t *published = (SDL_atomic_t*)&orbit->published;
+        SDL_atomic_t *complete = (SDL_atomic_t*)&orbit->complete;
+        SDL_atomic_t *cancel = (SDL_atomic_t*)&orbit->cancel;
+
+        SDL_LockMutex(orbit->publishLock);
+        while (SDL_AtomicGet(published) < count && !(SDL_AtomicGet(complete) && SDL_AtomicGet(published) > 0)
+               && !SDL_AtomicGet(cancel) && !(poolCancel && SDL_AtomicGet(poolCancel)))
+            SDL_CondWaitTimeout(orbit->publishCond, orbit->publishLock, ORBIT_WAIT_TIMEOUT_MS);
+        SDL_UnlockMutex(orbit->publishLock);
+        return SDL_AtomicGet(published);
+    }
+
+    // Vérifie que Z_m+1 existe pour un pixel en m dans l'orbite, en attendant sa publication
+    // Sur un noyau le pixel repart de Z_0 = Z_p au dernier point, faux si l'orbite s'arrête avant ou si le calcul est abandonné
+    static inline bool follow_orbit(const ReferenceOrbit *orbit, int *m, int *available, SDL_atomic_t *poolCancel) {
+        if (*m + 1 >= *available) {
+            *available = wait_orbit(orbit, *m + 2, poolCancel);
+            if (*m + 1 >= *available) {
+                if (orbit->period == 0 || SDL_AtomicGet((SDL_atomic_t*)&orbit->cancel))
+                    return false;
+                *m = 0;
+            }
+        }
+        return true;
+    }
+
+    // Série d'un dc multiplié par 2^-scale, calculée en floatexp: A dc peut sortir de la portée du double
+    // Le résultat est rendu à sa propre échelle, retournée
+    static int series_eval_scaled(const ReferenceOrbit *orbit, double dcx, double dcy, int scale, double *dx, double *dy) {
+        floatexp cx = fe_ldexp(fe_from_double(dcx), scale);
+        floatexp cy = fe_ldexp(fe_from_double(dcy), scale);
+        const double *coefficients[3] = { orbit->seriesC, orbit->seriesB, orbit->seriesA };
+
+        floatexp rx = fe_from_double(0.0), ry = fe_from_double(0.0);
+        for (int k = 0; k < 3; k++) {
+            rx = fe_add(rx, fe_from_double(coefficients[k][0]));
+            ry = fe_add(ry, fe_from_double(coefficients[k][1]));
+            floatexp t = fe_sub(fe_mul(rx, cx), fe_mul(ry, cy));
+            ry = fe_add(fe_mul(rx, cy), fe_mul(ry, cx));
+            rx = t;
+        }
+
+        int resultScale = largest(scale, largest(rx.exponent, ry.exponent));
+        if (resultScale >= FLOATEXP_DOUBLE_MIN_EXP)
+            resultScale = 0;
+        *dx = fe_to_double(fe_ldexp(rx, -resultScale));
+        *dy = fe_to_double(fe_ldexp(ry, -resultScale));
+        return resultScale;
+    }
+
+    // Itère le pixel d'écart dc à la référence, PERTURBATION_GLITCH si le résultat ne peut pas être juste
+    // dc est multiplié par 2^-scale (delta_scale): au-delà du double, l'écart reste à l'échelle jusqu'à ce qu'il y tienne
+    // *available est le nombre de points de l'orbite déjà publiés, mis à jour quand le pixel doit en attendre d'autres
+    // poolCancel arrête l'attente de l'orbite quand le pool abandonne le calcul, NULL hors du pool
+    static int perturb_pixel(const FractalTask *task, const ReferenceOrbit *orbit, double dcx, double dcy, int scale,
+                             int *available, SDL_atomic_t *poolCancel) {
+        double dx = 0.0, dy = 0.0;
+        int iteration = 0;
+        int m = 0;          // Position dans l'orbite de référence
+
+        // Départ à l'itération donnée par la série, sauf si le pixel s'est déjà échappé avant: il repart de 0
+        if (orbit->seriesSkip > 0) {
+            double sx, sy;
+            int seriesScale = 0;
+            if (scale == 0)
+                series_eval(orbit->seriesA, orbit->seriesB, orbit->seriesC, dcx, dcy, &sx, &sy);
+            else
+                seriesScale = series_eval_scaled(orbit, dcx, dcy, scale, &sx, &sy);
+
+            double S = ldexp(1.0, seriesScale);
+            double x = orbit->zr[orbit->seriesSkip] + S * sx;
+            double y = orbit->zi[orbit->seriesSkip] + S * sy;
+            if (x * x + y * y <= 4.0) {
+                dx = sx;
+                dy = sy;
+                dcx = ldexp(dcx, scale - seriesScale);
+                dcy = ldexp(dcy, scale - seriesScale);
+                scale = seriesScale;
+                iteration = m = orbit->seriesSkip;
+            }
+        }
+
+        // Ecarts trop petits pour le double: d et dc sont multipliés par 2^-scale, le terme d² devient S d²
+        if (scale < 0) {
+            double S = ldexp(1.0, scale);
+            while (scale < 0 && iteration < task->max_iteration) {
+                if (!follow_orbit(orbit, &m, available, poolCancel))
+                    break;
+
+                double zr = orbit->zr[m];
+                double zi = orbit->zi[m];
+                double x = zr + S * dx;
+                double y = zi + S * dy;
+                double normSqr = x * x + y * y;
+
+                if (normSqr > 4.0)
+                    return iteration;
+                if (normSqr < PERTURBATION_GLITCH_TOLERANCE * (zr * zr + zi * zi))
+                    return PERTURBATION_GLITCH;
+
+                double dxtemp = 2.0 * (zr * dx - zi * dy) + S * (dx * dx - dy * dy) + dcx;
+                dy = 2.0 * (zr * dy + zi * dx) + S * 2.0 * dx * dy + dcy;
+                dx = dxtemp;
+                iteration++;
+                m++;
+
+                if (fabs(dx) + fabs(dy) > PERTURBATION_RESCALE_LIMIT) {
+                    scale = rescale_deltas(&dx, &dy, &dcx, &dcy, scale);
+                    S = ldexp(1.0, scale);
+                }
+            }
+
+            // Fin du pixel à l'échelle: la boucle suivante ne fait plus que les tests de sortie
+            dx = ldexp(dx, scale);
+            dy = ldexp(dy, scale);
+        }
+
+        while (iteration < task->max_iteration) {
+            if (!follow_orbit(orbit, &m, available, poolCancel))
+                break;
+
+            double zr = orbit->zr[m];
+            double zi = orbit->zi[m];
+            double x = zr + dx;
+            double y = zi + dy;
+            double normSqr = x * x + y * y;
+
+            if (normSqr > 4.0)
+                return iteration;
+
+            // |Z + d| très petit devant |Z|: d a perdu ses chiffres significatifs
+            if (normSqr < PERTURBATION_GLITCH_TOLERANCE * (zr * zr + zi * zi))
+                return PERTURBATION_GLITCH;
+
+            // d = 2 Z d + d² + dc
+            double dxtemp = 2.0 * (zr * dx - zi * dy) + (dx * dx - dy * dy) + dcx;
+            dy = 2.0 * (zr * dy + zi * dx) + 2.0 * dx * dy + dcy;
+            dx = dxtemp;
+            iteration++;
+            m++;
+        }
+
+        if (iteration == task->max_iteration)
+            return iteration;
+
+        // L'orbite de référence s'est échappée avant le pixel
+        double x = orbit->zr[m] + dx;
+        double y = orbit->zi[m] + dy;
+        return (x * x + y * y > 4.0) ? iteration : PERTURBATION_GLITCH;
+    }
+
+    void calculate_iterations_perturbation(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) {
+        const ReferenceOrbit *orbit = task->reference;
+        int *row = task->iterationMap + py * task->width;
+
+        // En pipeline, l'orbite est peut-être encore en calcul: il faut au moins Z_0, publié avec l'écart du centre
+        int available = wait_orbit(orbit, 1, ctx->cancel);
+        if (available == 0)
+            return;
+
+        int scale = delta_scale(task);
+        double dcy = pixel_delta(task, py - task->height / 2.0, orbit->shiftY, scale);
+
+        // Orbite ou calcul abandonnés: les pixels restants ne serviront pas, même si les points publiés suffisent
+        for (int px = xStart; px < xEnd && !SDL_AtomicGet((SDL_atomic_t*)&orbit->cancel)
+                              && !(ctx->cancel && SDL_AtomicGet(ctx->cancel)); px++) {
+            double dcx = pixel_delta(task, px - task->width / 2.0, orbit->shiftX, scale);
+            row[px] = perturb_pixel(task, orbit, dcx, dcy, scale, &available, ctx->cancel);
+        }
+    }
+
+    bool perturbation_has_glitches(const FractalTask *task) {
+        int count = task->width * task->height;
+        for (int i = 0; i < count; i++) {
+            if (task->iterationMap[i] == PERTURBATION_GLITCH)
+                return true;
+        }
+        return false;
+    }
+
+    // Pixels glitchés reliés à start (4-connexité), rangés dans blob, retourne leur nombre
+    // visited doit être à 0 pour ces pixels, il est remis à 0 en sortant
+    static int glitch_blob(const FractalTask *task, int start, int *blob, uint8_t *visited) {
+        int w = task->width;
+        int h = task->height;
+        const int *map = task->iterationMap;
+
+        int count = 0;
+        blob[count++] = start;
+        visited[start] = 1;
+
+        // blob sert aussi de file pour le parcours en largeur
+        for (int head = 0; head < count; head++) {
+            int i = blob[head];
+            int x = i % w;
+            int y = i / w;
+            int neighbors[4] = { x > 0 ? i - 1 : -1, x < w - 1 ? i + 1 : -1, y > 0 ? i - w : -1, y < h - 1 ? i + w : -1 };
+            for (int k = 0; k < 4; k++) {
+                int j = neighbors[k];
+                if (j >= 0 && !visited[j] && map[j] == PERTURBATION_GLITCH) {
+                    visited[j] = 1;
+                    blob[count++] = j;
+                }
+            }
+        }
+
+        for (int k = 0; k < count; k++)
+            visited[blob[k]] = 0;
+        return count;
+    }
+
+    // Pixel du blob le plus proche de son barycentre, la nouvelle référence
+    static int blob_reference_pixel(const FractalTask *task, const int *blob, int count) {
+        int w = task->width;
+        double sumX = 0.0, sumY = 0.0;
+        for (int k = 0; k < count; k++) {
+            sumX += blob[k] % w;
+            sumY += blob[k] / w;
+        }
+        double meanX = sumX / count;
+        double meanY = sumY / count;
+
+        int best = blob[0];
+        double bestDistance = INFINITY;
+        for (int k = 0; k < count; k++) {
+            double dx = blob[k] % w - meanX;
+            double dy = blob[k] / w - meanY;
+            if (dx * dx + dy * dy < bestDistance) {
+                bestDistance = dx * dx + dy * dy;
+                best = blob[k];
+            }
+        }
+        return best;
+    }
+
+    // Derniers glitchs: calcul direct de chaque pixel, en virgule fixe ou en MPFR, jusqu'à ce que cancel passe à 1
+    static void compute_glitches_directly(const FractalTask *task, const SDL_atomic_t *cancel) {
+        WorkerContext ctx;
+        memset(&ctx, 0, sizeof(ctx));
+
+        SpanKernel kernel = fixed_point_kernel(task);
+        if (!kernel) {
+            kernel = calculate_iterations_high_precision_span;
+            high_precision_scratch_create(task, &ctx);
+        }
+
+        int w = task->width;
+        for (int i = 0; i < w * task->height && !SDL_AtomicGet((SDL_atomic_t*)cancel); i++) {
+            if (task->iterationMap[i] == PERTURBATION_GLITCH)
+                kernel(task, &ctx, i / w, i % w, i % w + 1);
+        }
+
+        if (ctx.scratch)
+            high_precision_scratch_destroy(task, &ctx);
+    }
+
+    int correct_glitches(void *arg) {
+        FractalTask *task = (FractalTask*)arg;
+        ReferenceOrbit *primary = task->reference;
+        int w = task->width;
+        int h = task->height;
+        int *map = task->iterationMap;
+
+        int scale = delta_scale(task);
+
+        int *blob = malloc((size_t)w * h * sizeof(int));
+        uint8_t *visited = calloc((size_t)w * h, 1);
+
+        ReferenceOrbit secondary;
+        reference_orbit_init(&secondary);
+
+        int glitched = 0;
+        for (int i = 0; i < w * h; i++)
+            glitched += map[i] == PERTURBATION_GLITCH;
+        int remaining = glitched;
+        *task->progress = 0;
+
+        // Les pixels avant start ne sont plus glitchés: seul le blob recalculé change à chaque passe
+        int start = 0;
+        int references = 0;
+        // Abandonnée entre deux références, ou pendant le calcul de l'une d'elles
+        while (remaining > 0 && references < PERTURBATION_MAX_REFERENCES && !SDL_AtomicGet(&primary->cancel)) {
+            while (map[start] != PERTURBATION_GLITCH)
+                start++;
+
+            int count = glitch_blob(task, start, blob, visited);
+            int reference = blob_reference_pixel(task, blob, count);
+
+            // Nouvelle référence au pixel choisi, avec le même écart au centre que celui des noyaux
+            // pour que son dc soit exactement nul: là où l'orbite est chaotique, le moindre écart grandirait
+            floatexp offsetX = fe_mul_d(task->pixelSize, reference % w - w / 2.0);
+            floatexp offsetY = fe_mul_d(task->pixelSize, reference / w - h / 2.0);
+            mpfr_set_prec(secondary.referenceX, mpfr_get_prec(task->centerX) + 64);
+            mpfr_set_prec(secondary.referenceY, mpfr_get_prec(task->centerY) + 64);
+            mpfr_set_d(secondary.referenceX, offsetX.mantissa, MPFR_RNDN);
+            mpfr_set_d(secondary.referenceY, offsetY.mantissa, MPFR_RNDN);
+            mpfr_mul_2si(secondary.referenceX, secondary.referenceX, offsetX.exponent, MPFR_RNDN);
+            mpfr_mul_2si(secondary.referenceY, secondary.referenceY, offsetY.exponent, MPFR_RNDN);
+            mpfr_add(secondary.referenceX, secondary.referenceX, task->centerX, MPFR_RNDN);
+            mpfr_add(secondary.referenceY, secondary.referenceY, task->centerY, MPFR_RNDN);
+            secondary.shiftX = fe_neg(offsetX);
+            secondary.shiftY = fe_neg(offsetY);
+            secondary.period = 0;
+            secondary.seriesSkip = 0;
+            if (!compute_orbit(task, &secondary, orbit_precision(task), &primary->cancel))
+                break;
+            int available = secondary.length;
+
+            // Le pixel de la référence ne peut pas glitcher: chaque passe en corrige au moins un
+            for (int k = 0; k < count; k++) {
+                int i = blob[k];
+                double dcx = pixel_delta(task, i % w - w / 2.0, secondary.shiftX, scale);
+                double dcy = pixel_delta(task, i / w - h / 2.0, secondary.shiftY, scale);
+                map[i] = perturb_pixel(task, &secondary, dcx, dcy, scale, &available, NULL);
+                remaining -= map[i] != PERTURBATION_GLITCH;
+            }
+
+            references++;
+            *task->progress = (int)((int64_t)(glitched - remaining) * 100 / glitched);
+
+            // Par sécurité, une référence qui glitche elle-même ne ferait plus avancer la correction
+            if (map[reference] == PERTURBATION_GLITCH)
+                break;
+        }
+
+        if (remaining > 0)
+            compute_glitches_directly(task, &primary->cancel);
+
+        for (int i = 0; i < w * h; i++)
+            *task->actual_max = largest(*task->actual_max, map[i]);
+
+        primary->glitchedPixels = glitched;
+        primary->secondaryReferences = references;
+
+        reference_orbit_free(&secondary);
+        free(blob);
+        free(visited);
+
+        SDL_AtomicSet(&primary->ready, 1);
+        return 0;
+    }
+
+    // calculate_iterations_bla avec des écarts en floatexp, quand ils sont trop petits pour le double
+    static void calculate_iterations_bla_exp(const FractalTask *task, int py, int xStart, int xEnd) {
+        const ReferenceOrbit *orbit = task->reference;
+        const BlaTable *bla = &orbit->bla;
+        int w = task->width;
+        int h = task->height;
+        int *row = task->iterationMap + py * w;
+        int maxIteration = task->max_iteration;
+        int end = orbit->length - 1;
+
+        const floatexp zero = fe_from_double(0.0);
+        floatexp dcy = fe_add(fe_mul_d(task->pixelSize, py - h / 2.0), orbit->shiftY);
+
+        for (int px = xStart; px < xEnd; px++) {
+            floatexp dcx = fe_add(fe_mul_d(task->pixelSize, px - w / 2.0), orbit->shiftX);
+
+            floatexp dx = zero, dy = zero;
+            int m = 0;
+            int iteration = 0;
+
+            if (end < 1) {
+                row[px] = iteration;
+                continue;
+            }
+
+            while (iteration < maxIteration) {
+                int steps;
+                floatexp dNormSqr = fe_add(fe_mul(dx, dx), fe_mul(dy, dy));
+                const BlaStepExp *step = bla_lookup_exp(bla, m, dNormSqr, smallest(maxIteration - iteration, end - m), &steps);
+
+                if (step) {
+                    // d = A d + B dc
+                    floatexp dxtemp = fe_add(fe_sub(fe_mul(step->A[0], dx), fe_mul(step->A[1], dy)),
+                                             fe_sub(fe_mul(step->B[0], dcx), fe_mul(step->B[1], dcy)));
+                    dy = fe_add(fe_add(fe_mul(step->A[0], dy), fe_mul(step->A[1], dx)),
+                                fe_add(fe_mul(step->B[0], dcy), fe_mul(step->B[1], dcx)));
+                    dx = dxtemp;
+                } else {
+                    // d = 2 Z d + d² + dc
+                    double zr2 = 2.0 * orbit->zr[m];
+                    double zi2 = 2.0 * orbit->zi[m];
+                    floatexp dxtemp = fe_add(fe_add(fe_sub(fe_mul_d(dx, zr2), fe_mul_d(dy, zi2)),
+                                                    fe_sub(fe_mul(dx, dx), fe_mul(dy, dy))), dcx);
+                    dy = fe_add(fe_add(fe_add(fe_mul_d(dy, zr2), fe_mul_d(dx, zi2)),
+                                       fe_ldexp(fe_mul(dx, dy), 1)), dcy);
+                    dx = dxtemp;
+                    steps = 1;
+                }
+                m += steps;
+                iteration += steps;
+
+                double ddx = fe_to_double(dx);
+                double ddy = fe_to_double(dy);
+                double x = orbit->zr[m] + ddx;
+                double y = orbit->zi[m] + ddy;
+                double normSqr = x * x + y * y;
+                if (normSqr > 4.0)
+                    break;
+
+                if (normSqr < ddx * ddx + ddy * ddy || m == end) {
+                    dx = fe_from_double(x);
+                    dy = fe_from_double(y);
+                    m = 0;
+                }
+            }
+
+            row[px] = iteration;
+        }
+    }
+
+    void calculate_iterations_bla(const FractalTask *task, WorkerContext *ctx, int py, int xStart, int xEnd) {
+        const ReferenceOrbit *orbit = task->reference;
+        const BlaTable *bla = &orbit->bla;
+
+        if (bla->extended) {
+            calculate_iterations_bla_exp(task, py, xStart, xEnd);
+            return;
+        }
+
+        int w = task->width;
+        int h = task->height;
+        int *row = task->iterationMap + py * w;
+        int maxIteration = task->max_iteration;
+
+        // Dernier point de l'orbite de référence, le pixel repart au début en l'atteignant
+        int end = orbit->length - 1;
+
+        double dcy = (py - h / 2.0) / task->zoom + fe_to_double(orbit->shiftY);
+
+        for (int px = xStart; px < xEnd; px++) {
+            double dcx = (px - w / 2.0) / task->zoom + fe_to_double(orbit->shiftX);
+
+            double dx = 0.0, dy = 0.0;
+            int m = 0;          // Position dans l'orbite de référence
+            int iteration = 0;  // Itération du pixel
+
+            // Une orbite de référence réduite à Z_0 ne permet aucun pas
+            if (end < 1) {
+                row[px] = iteration;
+                continue;
+            }
+
+            while (iteration < maxIteration) {
+                int steps;
+                const BlaStep *step = bla_lookup(bla, m, dx * dx + dy * dy, smallest(maxIteration - iteration, end - m), &steps);
+
+                if (step) {
+                    // d = A d + B dc
+                    double dxtemp = step->A[0] * dx - step->A[1] * dy + step->B[0] * dcx - step->B[1] * dcy;
+                    dy = step->A[0] * dy + step->A[1] * dx + step->B[0] * dcy + step->B[1] * dcx;
+                    dx = dxtemp;
+                } else {
+                    // d = 2 Z d + d² + dc
+                    double zr = orbit->zr[m];
+                    double zi = orbit->zi[m];
+                    double dxtemp = 2.0 * (zr * dx - zi * dy) + (dx * dx - dy * dy) + dcx;
+                    dy = 2.0 * (zr * dy + zi * dx) + 2.0 * dx * dy + dcy;
+                    dx = dxtemp;
+                    steps = 1;
+                }
+                m += steps;
+                iteration += steps;
+
+                double x = orbit->zr[m] + dx;
+                double y = orbit->zi[m] + dy;
+                double normSqr = x * x + y * y;
+                if (normSqr > 4.0)
+                    break;
+
+                // Rebasing: l'écart devient z lui-même, relatif à Z_0 = 0
+                if (normSqr < dx * dx + dy * dy || m == end) {
+                    dx = x;
+                    dy = y;
+                    m = 0;
+                }
+            }
+
+            row[px] = iteration;
+        }
+    }
+
+#endif
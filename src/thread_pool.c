@@ -0,0 +1,326 @@
+
+/*
+
+    Pool de threads persistant pour le calcul du Mandelbrot
+
+    L'image est découpée en tuiles carrées, chaque worker reçoit au départ une
+    suite contiguë de tuiles. Le coût d'une tuile variant énormément (intérieur
+    de l'ensemble contre extérieur), un worker qui a vidé sa file vole la moitié
+    de la file restante d'un autre worker.
+
+*/
+
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include "thread_pool.h"
+#include "tile_render.h"
+
+// Taille d'une ligne de cache, pour éviter que deux workers écrivent sur la même
+#define CACHE_LINE 64
+
+
+struct Worker {
+    WorkerContext ctx;
+
+    // File de tuiles [begin, end[ du worker, protégée par le spinlock
+    SDL_SpinLock lock;
+    int begin, end;
+
+    ThreadPool *pool;
+};
+
+// Chaque worker occupe ses propres lignes de cache
+typedef union {
+    struct Worker worker;
+    char padding[CACHE_LINE * ((sizeof(struct Worker) + CACHE_LINE - 1) / CACHE_LINE)];
+} PaddedWorker;
+
+struct ThreadPool {
+    int threadCount;
+    int tileSize;
+    SDL_Thread **threads;
+    PaddedWorker *workers;
+
+    // Réveil des workers à chaque nouveau calcul et attente de la fin
+    SDL_mutex *mutex;
+    SDL_cond *wakeUp;
+    SDL_cond *idle;
+    int generation;
+    bool quit;
+
+    // Calcul en cours
+    FractalTask *task;
+    SpanKernel kernel;
+    ScratchHook createScratch, destroyScratch;   // NULL pour les noyaux sans variables de travail
+    int currentTileSize;   // tileSize, ou toute l'image pour les modes qui la traitent d'un seul tenant
+    int tilesX;
+    int tileCount;
+    SDL_atomic_t busyWorkers;
+    SDL_atomic_t cancel;
+
+    // Vrai tant que le résultat n'a pas été remis au thread principal
+    bool running;
+};
+
+
+// Récupère la prochaine tuile à calculer, dans sa file ou en volant un autre worker
+static bool next_tile(ThreadPool *pool, struct Worker *self, int *tile) {
+
+    SDL_AtomicLock(&self->lock);
+    if (self->begin < self->end) {
+        *tile = self->begin++;
+        SDL_AtomicUnlock(&self->lock);
+        return true;
+    }
+    SDL_AtomicUnlock(&self->lock);
+
+    // File vide: on prend la moitié de la fin de la file du premier worker qui a encore du travail
+    for (int i = 1; i < pool->threadCount; i++) {
+        struct Worker *victim = &pool->workers[(self->ctx.index + i) % pool->threadCount].worker;
+
+        SDL_AtomicLock(&victim->lock);
+        int available = victim->end - victim->begin;
+        if (available > 0) {
+            int stolen = (available + 1) / 2;
+            int stolenBegin = victim->end - stolen;
+            victim->end = stolenBegin;
+            SDL_AtomicUnlock(&victim->lock);
+
+            // La première tuile volée est calculée tout de suite, le reste rejoint notre file
+            SDL_AtomicLock(&self->lock);
+            self->begin = stolenBegin + 1;
+            self->end = stolenBegin + stolen;
+            SDL_AtomicUnlock(&self->lock);
+
+            *tile = stolenBegin;
+            return true;
+        }
+        SDL_AtomicUnlock(&victim->lock);
+    }
+
+    return false;
+}
+
+// Calcule une tuile selon le mode de rendu de la tâche et met à jour les statistiques locales du worker
+static void compute_tile(ThreadPool *pool, struct Worker *self, int tile) {
+    const FractalTask *task = pool->task;
+
+    int x0 = (tile % pool->tilesX) * pool->currentTileSize;
+    int y0 = (tile / pool->tilesX) * pool->currentTileSize;
+    int x1 = smallest(x0 + pool->currentTileSize, task->width);
+    int y1 = smallest(y0 + pool->currentTileSize, task->height);
+
+    render_tile(task, &self->ctx, pool->kernel, x0, y0, x1, y1);
+
+    SDL_AtomicAdd(&self->ctx.pixelsDone, (x1 - x0) * (y1 - y0));
+}
+
+// Boucle d'un worker: attend un calcul, vide les tuiles, puis se rendort
+static int worker_main(void *arg) {
+    struct Worker *self = (struct Worker*)arg;
+    ThreadPool *pool = self->pool;
+    int seenGeneration = 0;
+
+    while (true) {
+        SDL_LockMutex(pool->mutex);
+        while (!pool->quit && pool->generation == seenGeneration) {
+            SDL_CondWait(pool->wakeUp, pool->mutex);
+        }
+        if (pool->quit) {
+            SDL_UnlockMutex(pool->mutex);
+            break;
+        }
+        seenGeneration = pool->generation;
+        SDL_UnlockMutex(pool->mutex);
+
+        if (pool->createScratch)
+            pool->createScratch(pool->task, &self->ctx);
+
+        int tile;
+        while (!SDL_AtomicGet(&pool->cancel) && next_tile(pool, self, &tile)) {
+            compute_tile(pool, self, tile);
+        }
+
+        if (pool->destroyScratch)
+            pool->destroyScratch(pool->task, &self->ctx);
+
+        // Le dernier worker à finir prévient ceux qui attendent la fin du calcul
+        if (SDL_AtomicAdd(&pool->busyWorkers, -1) == 1) {
+            SDL_LockMutex(pool->mutex);
+            SDL_CondBroadcast(pool->idle);
+            SDL_UnlockMutex(pool->mutex);
+        }
+    }
+
+    return 0;
+}
+
+
+
+// Crée le pool et démarre ses workers, qui restent endormis jusqu'au premier calcul
+ThreadPool *thread_pool_create(int threadCount, int tileSize) {
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+
+    if (threadCount <= 0) {
+        threadCount = SDL_GetCPUCount();
+    }
+    if (tileSize <= 0) {
+        tileSize = DEFAULT_TILE_SIZE;
+    }
+
+    pool->threadCount = threadCount;
+    pool->tileSize = tileSize;
+    pool->threads = calloc(threadCount, sizeof(SDL_Thread*));
+    pool->workers = calloc(threadCount, sizeof(PaddedWorker));
+    pool->mutex = SDL_CreateMutex();
+    pool->wakeUp = SDL_CreateCond();
+    pool->idle = SDL_CreateCond();
+
+    for (int i = 0; i < threadCount; i++) {
+        struct Worker *worker = &pool->workers[i].worker;
+        worker->ctx.index = i;
+        worker->ctx.cancel = &pool->cancel;
+        worker->pool = pool;
+        pool->threads[i] = SDL_CreateThread(worker_main, "CalcFractalWorker", worker);
+    }
+
+    return pool;
+}
+
+// Arrête le calcul en cours, termine les workers et libère le pool
+void thread_pool_destroy(ThreadPool *pool) {
+    thread_pool_cancel(pool);
+    thread_pool_wait(pool);
+
+    SDL_LockMutex(pool->mutex);
+    pool->quit = true;
+    SDL_CondBroadcast(pool->wakeUp);
+    SDL_UnlockMutex(pool->mutex);
+
+    for (int i = 0; i < pool->threadCount; i++) {
+        SDL_WaitThread(pool->threads[i], NULL);
+    }
+
+    SDL_DestroyCond(pool->idle);
+    SDL_DestroyCond(pool->wakeUp);
+    SDL_DestroyMutex(pool->mutex);
+    free(pool->workers);
+    free(pool->threads);
+    free(pool);
+}
+
+// Distribue les tuiles de l'image aux workers et les réveille
+void thread_pool_launch(ThreadPool *pool, FractalTask *task, SpanKernel kernel) {
+    thread_pool_launch_scratch(pool, task, kernel, NULL, NULL);
+}
+
+void thread_pool_launch_scratch(ThreadPool *pool, FractalTask *task, SpanKernel kernel,
+                                ScratchHook createScratch, ScratchHook destroyScratch) {
+
+    // Un seul calcul à la fois: le précédent est abandonné
+    thread_pool_cancel(pool);
+    thread_pool_wait(pool);
+
+    pool->task = task;
+    pool->kernel = kernel;
+    pool->createScratch = createScratch;
+    pool->destroyScratch = destroyScratch;
+    pool->currentTileSize = (task->renderMode == RENDER_TRACE_FRAME) ? largest(task->width, task->height) : pool->tileSize;
+    pool->tilesX = (task->width + pool->currentTileSize - 1) / pool->currentTileSize;
+    int tilesY = (task->height + pool->currentTileSize - 1) / pool->currentTileSize;
+    pool->tileCount = pool->tilesX * tilesY;
+
+    *task->actual_max = 0;
+    *task->progress = 0;
+    *task->finished = false;
+
+    // Chaque worker commence avec une suite contiguë de tuiles
+    for (int i = 0; i < pool->threadCount; i++) {
+        struct Worker *worker = &pool->workers[i].worker;
+        worker->begin = (int)((int64_t)pool->tileCount * i / pool->threadCount);
+        worker->end = (int)((int64_t)pool->tileCount * (i + 1) / pool->threadCount);
+        worker->ctx.localMax = 0;
+        worker->ctx.iterationsSaved = 0;
+        worker->ctx.pixelsComputed = 0;
+        worker->ctx.fillErrors = 0;
+        worker->ctx.checkPeriodicity = true;
+        SDL_AtomicSet(&worker->ctx.pixelsDone, 0);
+    }
+
+    SDL_AtomicSet(&pool->cancel, 0);
+    SDL_AtomicSet(&pool->busyWorkers, pool->threadCount);
+    pool->running = true;
+
+    SDL_LockMutex(pool->mutex);
+    pool->generation++;
+    SDL_CondBroadcast(pool->wakeUp);
+    SDL_UnlockMutex(pool->mutex);
+}
+
+// Réduit les compteurs des workers dans la tâche, appelée par le thread principal
+void thread_pool_update(ThreadPool *pool) {
+    if (!pool->running) {
+        return;
+    }
+
+    FractalTask *task = pool->task;
+
+    int64_t done = 0;
+    for (int i = 0; i < pool->threadCount; i++) {
+        done += SDL_AtomicGet(&pool->workers[i].worker.ctx.pixelsDone);
+    }
+    *task->progress = (int)((done * 100) / ((int64_t)task->width * task->height));
+
+    // Calcul interrompu: les workers rendormis, l'image incomplète n'est pas rendue
+    if (SDL_AtomicGet(&pool->cancel)) {
+        if (SDL_AtomicGet(&pool->busyWorkers) == 0) {
+            pool->running = false;
+        }
+        return;
+    }
+
+    // Tous les workers sont rendormis: leurs résultats sont visibles
+    if (SDL_AtomicGet(&pool->busyWorkers) == 0) {
+        int actualMax = 0;
+        int64_t iterationsSaved = 0, pixelsComputed = 0, fillErrors = 0;
+        for (int i = 0; i < pool->threadCount; i++) {
+            const WorkerContext *ctx = &pool->workers[i].worker.ctx;
+            actualMax = largest(actualMax, ctx->localMax);
+            iterationsSaved += ctx->iterationsSaved;
+            pixelsComputed += ctx->pixelsComputed;
+            fillErrors += ctx->fillErrors;
+        }
+
+        *task->actual_max = actualMax;
+        if (task->iterationsSaved)
+            *task->iterationsSaved = iterationsSaved;
+        if (task->pixelsComputed)
+            *task->pixelsComputed = pixelsComputed;
+        if (task->fillErrors)
+            *task->fillErrors = fillErrors;
+        *task->progress = 100;
+        *task->finished = true;
+        pool->running = false;
+    }
+}
+
+// Bloque jusqu'à ce que tous les workers aient terminé, puis remet le résultat
+void thread_pool_wait(ThreadPool *pool) {
+    SDL_LockMutex(pool->mutex);
+    while (SDL_AtomicGet(&pool->busyWorkers) > 0) {
+        SDL_CondWait(pool->idle, pool->mutex);
+    }
+    SDL_UnlockMutex(pool->mutex);
+
+    thread_pool_update(pool);
+}
+
+void thread_pool_cancel(ThreadPool *pool) {
+    SDL_AtomicSet(&pool->cancel, 1);
+}
+
+int thread_pool_thread_count(const ThreadPool *pool) {
+    return pool->threadCount;
+}
@@ -0,0 +1,350 @@
+
+/*
+
+    Parcours d'une tuile de l'image
+
+    En mode pixels, chaque ligne de la tuile est donnée au noyau.
+
+    En mode subdivision (Mariani-Silver), seul le bord de la tuile est calculé.
+    Si tout le bord a le même nombre d'itérations, l'intérieur est rempli avec
+    cette valeur: l'ensemble de Mandelbrot et ses bandes d'échappement étant
+    connexes, une zone d'une autre valeur ne peut être entièrement entourée que
+    si elle contient tout l'ensemble (vue dézoomée), ou si elle passe entre les
+    pixels du bord. Les pixels intérieurs de la grille de pas FILL_SEED_STEP
+    sont donc calculés aussi avant de remplir. Sinon le rectangle est coupé en
+    deux par une ligne calculée, et chaque moitié est traitée de la même façon
+    avec son bord désormais connu.
+
+    En mode contours, on part des pixels du bord de la zone et on suit les
+    frontières entre nombres d'itérations différents: un pixel dont un voisin a
+    une autre valeur est sur une frontière, ses voisins sont alors calculés à
+    leur tour. Les pixels jamais atteints sont entourés d'une frontière de même
+    valeur, ils prennent la valeur de leur voisin de gauche. Pour les mêmes
+    zones entièrement entourées, chaque pixel non atteint de la grille est
+    calculé: s'il n'a pas la valeur qu'il aurait reçue, les frontières sont
+    suivies à partir de lui aussi.
+
+*/
+
+#include <stdlib.h>
+
+#include "tile_render.h"
+
+// Etat des pixels de la zone suivie en mode contours
+#define TRACE_COMPUTED 1
+#define TRACE_QUEUED 2
+
+
+// Calcule une portion de ligne avec le noyau et la compte, rien si le calcul est abandonné
+static void compute_span(const FractalTask *task, WorkerContext *ctx, SpanKernel kernel, int py, int xStart, int xEnd) {
+    if (xStart >= xEnd || (ctx->cancel && SDL_AtomicGet(ctx->cancel)))
+        return;
+
+    kernel(task, ctx, py, xStart, xEnd);
+    ctx->pixelsComputed += xEnd - xStart;
+}
+
+// Calcule une portion de colonne, pixel par pixel
+static void compute_column(const FractalTask *task, WorkerContext *ctx, SpanKernel kernel, int px, int yStart, int yEnd) {
+    for (int py = yStart; py < yEnd; py++) {
+        compute_span(task, ctx, kernel, py, px, px + 1);
+    }
+}
+
+// Vrai si tous les pixels du bord de [x0, x1[ x [y0, y1[ ont la même valeur, renvoyée dans *value
+static bool uniform_border(const FractalTask *task, int x0, int y0, int x1, int y1, int *value) {
+    const int *map = task->iterationMap;
+    int w = task->width;
+    int v = map[y0 * w + x0];
+
+    for (int px = x0; px < x1; px++) {
+        if (map[y0 * w + px] != v || map[(y1 - 1) * w + px] != v)
+            return false;
+    }
+    for (int py = y0 + 1; py < y1 - 1; py++) {
+        if (map[py * w + x0] != v || map[py * w + x1 - 1] != v)
+            return false;
+    }
+
+    *value = v;
+    return true;
+}
+
+// Premier pixel de la grille de pas FILL_SEED_STEP à partir de start, dans les coordonnées de l'image
+static int first_seed(int start) {
+    int offset = FILL_SEED_STEP / 2;
+    return start + ((offset - start) % FILL_SEED_STEP + FILL_SEED_STEP) % FILL_SEED_STEP;
+}
+
+// Vrai si les pixels de la grille à l'intérieur de [x0, x1[ x [y0, y1[ ont tous la valeur value, calculés ici
+static bool uniform_seeds(const FractalTask *task, WorkerContext *ctx, SpanKernel kernel, int x0, int y0, int x1, int y1, int value) {
+    const int *map = task->iterationMap;
+    int w = task->width;
+
+    for (int py = first_seed(y0 + 1); py < y1 - 1; py += FILL_SEED_STEP) {
+        for (int px = first_seed(x0 + 1); px < x1 - 1; px += FILL_SEED_STEP) {
+            compute_span(task, ctx, kernel, py, px, px + 1);
+            if (map[py * w + px] != value)
+                return false;
+        }
+    }
+    return true;
+}
+
+// Un pixel rempli n'a pas d'état de reprise: s'il doit continuer au prochain maximum, il repartira de zéro
+static void forget_resume_state(const FractalTask *task, int py, int xStart, int xEnd) {
+    if (!task->resumeX)
+        return;
+
+    for (int px = xStart; px < xEnd; px++) {
+        task->resumeX[py * task->width + px] = 0.0;
+        task->resumeY[py * task->width + px] = 0.0;
+    }
+}
+
+// Remplit l'intérieur de [x0, x1[ x [y0, y1[ avec value
+// En mode vérification les pixels sont calculés malgré tout et les écarts comptés, l'image reste exacte
+static void fill_interior(const FractalTask *task, WorkerContext *ctx, SpanKernel kernel, int x0, int y0, int x1, int y1, int value) {
+    int w = task->width;
+
+    for (int py = y0 + 1; py < y1 - 1; py++) {
+        int *row = task->iterationMap + py * w;
+
+        if (task->verifyFills) {
+            compute_span(task, ctx, kernel, py, x0 + 1, x1 - 1);
+            for (int px = x0 + 1; px < x1 - 1; px++) {
+                if (row[px] != value)
+                    ctx->fillErrors++;
+            }
+        } else {
+            for (int px = x0 + 1; px < x1 - 1; px++) {
+                row[px] = value;
+            }
+            forget_resume_state(task, py, x0 + 1, x1 - 1);
+        }
+    }
+}
+
+// Traite un rectangle dont le bord est déjà calculé
+static void subdivide(const FractalTask *task, WorkerContext *ctx, SpanKernel kernel, int x0, int y0, int x1, int y1) {
+    int w = x1 - x0;
+    int h = y1 - y0;
+
+    // Pas d'intérieur
+    if (w <= 2 || h <= 2)
+        return;
+
+    // Une zone qui contient un pixel de la grille d'une autre valeur est découpée comme un bord non uniforme
+    int value;
+    if (uniform_border(task, x0, y0, x1, y1, &value) && uniform_seeds(task, ctx, kernel, x0, y0, x1, y1, value)) {
+        fill_interior(task, ctx, kernel, x0, y0, x1, y1, value);
+        return;
+    }
+
+    // Trop petit pour que le découpage fasse gagner quelque chose
+    if (w < SUBDIVIDE_MIN_SIZE || h < SUBDIVIDE_MIN_SIZE) {
+        for (int py = y0 + 1; py < y1 - 1; py++) {
+            compute_span(task, ctx, kernel, py, x0 + 1, x1 - 1);
+        }
+        return;
+    }
+
+    // Coupe le plus grand côté en deux, la ligne de coupe appartient aux bords des deux moitiés
+    if (w >= h) {
+        int xm = x0 + w / 2;
+        compute_column(task, ctx, kernel, xm, y0 + 1, y1 - 1);
+        subdivide(task, ctx, kernel, x0, y0, xm + 1, y1);
+        subdivide(task, ctx, kernel, xm, y0, x1, y1);
+    } else {
+        int ym = y0 + h / 2;
+        compute_span(task, ctx, kernel, ym, x0 + 1, x1 - 1);
+        subdivide(task, ctx, kernel, x0, y0, x1, ym + 1);
+        subdivide(task, ctx, kernel, x0, ym, x1, y1);
+    }
+}
+
+// Mariani-Silver sur une tuile: calcule son bord puis la subdivise
+static void render_subdivide(const FractalTask *task, WorkerContext *ctx, SpanKernel kernel, int x0, int y0, int x1, int y1) {
+    compute_span(task, ctx, kernel, y0, x0, x1);
+    if (y1 - y0 > 1)
+        compute_span(task, ctx, kernel, y1 - 1, x0, x1);
+
+    compute_column(task, ctx, kernel, x0, y0 + 1, y1 - 1);
+    if (x1 - x0 > 1)
+        compute_column(task, ctx, kernel, x1 - 1, y0 + 1, y1 - 1);
+
+    subdivide(task, ctx, kernel, x0, y0, x1, y1);
+}
+
+
+// Zone suivie en mode contours
+typedef struct {
+    const FractalTask *task;
+    WorkerContext *ctx;
+    SpanKernel kernel;
+    int x0, y0, w, h;
+    unsigned char *state;   // TRACE_COMPUTED | TRACE_QUEUED par pixel de la zone
+    int *queue;             // Chaque pixel n'y entre qu'une fois, la zone entière suffit
+    int queueBegin, queueEnd;
+} TraceRegion;
+
+// Nombre d'itérations du pixel p de la zone, calculé au premier accès
+static int trace_load(TraceRegion *r, int p) {
+    int px = r->x0 + p % r->w;
+    int py = r->y0 + p / r->w;
+
+    if (!(r->state[p] & TRACE_COMPUTED)) {
+        compute_span(r->task, r->ctx, r->kernel, py, px, px + 1);
+        r->state[p] |= TRACE_COMPUTED;
+    }
+    return r->task->iterationMap[py * r->task->width + px];
+}
+
+static void trace_enqueue(TraceRegion *r, int p) {
+    if (r->state[p] & TRACE_QUEUED)
+        return;
+
+    r->state[p] |= TRACE_QUEUED;
+    r->queue[r->queueEnd++] = p;
+}
+
+// Compare le pixel à ses 4 voisins, ceux d'une autre valeur sont sur la frontière et seront examinés à leur tour
+static void trace_scan(TraceRegion *r, int p) {
+    int x = p % r->w;
+    int y = p / r->w;
+    int center = trace_load(r, p);
+
+    bool hasLeft = x > 0, hasRight = x < r->w - 1;
+    bool hasUp = y > 0, hasDown = y < r->h - 1;
+
+    bool left = hasLeft && trace_load(r, p - 1) != center;
+    bool right = hasRight && trace_load(r, p + 1) != center;
+    bool up = hasUp && trace_load(r, p - r->w) != center;
+    bool down = hasDown && trace_load(r, p + r->w) != center;
+
+    if (left) trace_enqueue(r, p - 1);
+    if (right) trace_enqueue(r, p + 1);
+    if (up) trace_enqueue(r, p - r->w);
+    if (down) trace_enqueue(r, p + r->w);
+
+    // Les diagonales évitent qu'une frontière en escalier laisse fuir le remplissage
+    if (hasUp && hasLeft && (up || left)) trace_enqueue(r, p - r->w - 1);
+    if (hasUp && hasRight && (up || right)) trace_enqueue(r, p - r->w + 1);
+    if (hasDown && hasLeft && (down || left)) trace_enqueue(r, p + r->w - 1);
+    if (hasDown && hasRight && (down || right)) trace_enqueue(r, p + r->w + 1);
+}
+
+// Suit les frontières à partir du bord de la zone, puis remplit les pixels non atteints
+static void render_trace(const FractalTask *task, WorkerContext *ctx, SpanKernel kernel, int x0, int y0, int x1, int y1) {
+    TraceRegion r;
+    r.task = task;
+    r.ctx = ctx;
+    r.kernel = kernel;
+    r.x0 = x0;
+    r.y0 = y0;
+    r.w = x1 - x0;
+    r.h = y1 - y0;
+    r.state = calloc((size_t)r.w * r.h, sizeof(unsigned char));
+    r.queue = malloc((size_t)r.w * r.h * sizeof(int));
+    r.queueBegin = r.queueEnd = 0;
+
+    for (int x = 0; x < r.w; x++) {
+        trace_enqueue(&r, x);
+        trace_enqueue(&r, (r.h - 1) * r.w + x);
+    }
+    for (int y = 1; y < r.h - 1; y++) {
+        trace_enqueue(&r, y * r.w);
+        trace_enqueue(&r, y * r.w + r.w - 1);
+    }
+
+    while (r.queueBegin < r.queueEnd) {
+        trace_scan(&r, r.queue[r.queueBegin++]);
+    }
+
+    // Pixels de la grille non atteints: comparés à la valeur que le remplissage leur donnerait
+    for (int y = first_seed(y0) - y0; y < r.h; y += FILL_SEED_STEP) {
+        for (int x = first_seed(x0) - x0; x < r.w; x += FILL_SEED_STEP) {
+            int p = y * r.w + x;
+            if (r.state[p] & TRACE_COMPUTED)
+                continue;
+
+            int left = p - 1;
+            while (!(r.state[left] & TRACE_COMPUTED))
+                left--;
+
+            if (trace_load(&r, p) != trace_load(&r, left)) {
+                trace_enqueue(&r, p);
+                while (r.queueBegin < r.queueEnd) {
+                    trace_scan(&r, r.queue[r.queueBegin++]);
+                }
+            }
+        }
+    }
+
+    // La colonne de gauche fait partie du bord, chaque ligne a donc toujours une valeur de départ
+    for (int y = 0; y < r.h; y++) {
+        int *row = task->iterationMap + (y0 + y) * task->width + x0;
+        const unsigned char *state = r.state + y * r.w;
+
+        int fillValue = row[0];
+
+        for (int x = 1; x < r.w; x++) {
+            if (state[x] & TRACE_COMPUTED) {
+                fillValue = row[x];
+                continue;
+            }
+
+            if (task->verifyFills) {
+                compute_span(task, ctx, kernel, y0 + y, x0 + x, x0 + x + 1);
+                if (row[x] != fillValue)
+                    ctx->fillErrors++;
+            } else {
+                row[x] = fillValue;
+                forget_resume_state(task, y0 + y, x0 + x, x0 + x + 1);
+            }
+        }
+    }
+
+    free(r.queue);
+    free(r.state);
+}
+
+
+void render_tile(const FractalTask *task, WorkerContext *ctx, SpanKernel kernel, int x0, int y0, int x1, int y1) {
+    switch (task->renderMode) {
+        case RENDER_SUBDIVIDE:
+            render_subdivide(task, ctx, kernel, x0, y0, x1, y1);
+            break;
+        case RENDER_TRACE:
+        case RENDER_TRACE_FRAME:
+            render_trace(task, ctx, kernel, x0, y0, x1, y1);
+            break;
+        default:
+            for (int py = y0; py < y1; py++) {
+                compute_span(task, ctx, kernel, py, x0, x1);
+            }
+    }
+
+    int localMax = ctx->localMax;
+    for (int py = y0; py < y1; py++) {
+        const int *row = task->iterationMap + py * task->width;
+        for (int px = x0; px < x1; px++) {
+            if (row[px] > localMax)
+                localMax = row[px];
+        }
+    }
+    ctx->localMax = localMax;
+}
+
+const char *render_mode_name(RenderMode mode) {
+    switch (mode) {
+        case RENDER_SUBDIVIDE:
+            return "SUBDIVISION";
+        case RENDER_TRACE:
+            return "CONTOURS PAR TUILE";
+        case RENDER_TRACE_FRAME:
+            return "CONTOURS";
+        default:
+            return "PIXELS";
+    }
+}
@@ -0,0 +1,258 @@
+
+/*
+
+    Vue sur la fractale: centre et zoom
+
+    Les déplacements sont toujours des nombres de pixels, convertis avec la
+    taille d'un pixel en floatexp puis ajoutés exactement au centre.
+
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "view.h"
+
+
+#ifdef __linux__
+
+    // Précision du centre pour un zoom: assez pour la taille d'un pixel, plus une marge
+    static mpfr_prec_t view_precision(floatexp zoom) {
+        return largest((mpfr_prec_t)53, (mpfr_prec_t)zoom.exponent + VIEW_GUARD_BITS);
+    }
+
+    // Augmente la précision du centre si le zoom le demande, elle ne baisse jamais pour ne pas perdre de chiffres
+    static void fit_precision(FractalView *view) {
+        mpfr_prec_t precision = view_precision(view->zoom);
+        if (precision > mpfr_get_prec(view->x)) {
+            mpfr_prec_round(view->x, precision, MPFR_RNDN);
+            mpfr_prec_round(view->y, precision, MPFR_RNDN);
+        }
+    }
+
+    // value += pixels / zoom
+    static void add_pixels(mpfr_t value, double pixels, floatexp zoom) {
+        floatexp delta = fe_div(fe_from_double(pixels), zoom);
+
+        mpfr_t d;
+        mpfr_init2(d, 53);
+        mpfr_set_d(d, delta.mantissa, MPFR_RNDN);
+        mpfr_mul_2si(d, d, delta.exponent, MPFR_RNDN);
+        mpfr_add(value, value, d, MPFR_RNDN);
+        mpfr_clear(d);
+    }
+
+    // Lit text dans value, à une précision suffisante pour tous ses chiffres
+    static bool parse_center(mpfr_t value, const char *text, floatexp zoom) {
+        mpfr_prec_t precision = largest(view_precision(zoom), (mpfr_prec_t)(strlen(text) * 3.33) + 16);
+
+        mpfr_t parsed;
+        mpfr_init2(parsed, precision);
+        char *end;
+        mpfr_strtofr(parsed, text, &end, 10, MPFR_RNDN);
+
+        bool valid = *end == '\0' && mpfr_number_p(parsed);
+        if (valid) {
+            mpfr_set_prec(value, precision);
+            mpfr_set(value, parsed, MPFR_RNDN);
+        }
+        mpfr_clear(parsed);
+        return valid;
+    }
+
+#endif
+
+
+void view_init(FractalView *view, double x, double y, double zoom) {
+    view->zoom = fe_from_double(zoom);
+    #ifdef __linux__
+        mpfr_init2(view->x, view_precision(view->zoom));
+        mpfr_init2(view->y, view_precision(view->zoom));
+        mpfr_set_d(view->x, x, MPFR_RNDN);
+        mpfr_set_d(view->y, y, MPFR_RNDN);
+    #else
+        view->x = x;
+        view->y = y;
+    #endif
+}
+
+void view_clear(FractalView *view) {
+    #ifdef __linux__
+        mpfr_clear(view->x);
+        mpfr_clear(view->y);
+    #else
+        (void)view;
+    #endif
+}
+
+void view_copy(FractalView *dst, const FractalView *src) {
+    dst->zoom = src->zoom;
+    #ifdef __linux__
+        mpfr_set_prec(dst->x, mpfr_get_prec(src->x));
+        mpfr_set_prec(dst->y, mpfr_get_prec(src->y));
+        mpfr_set(dst->x, src->x, MPFR_RNDN);
+        mpfr_set(dst->y, src->y, MPFR_RNDN);
+    #else
+        dst->x = src->x;
+        dst->y = src->y;
+    #endif
+}
+
+void view_move(FractalView *view, double dx, double dy) {
+    #ifdef __linux__
+        add_pixels(view->x, dx, view->zoom);
+        add_pixels(view->y, dy, view->zoom);
+    #else
+        view->x += fe_to_double(fe_div(fe_from_double(dx), view->zoom));
+        view->y += fe_to_double(fe_div(fe_from_double(dy), view->zoom));
+    #endif
+}
+
+void view_zoom_at(FractalView *view, double factor, int px, int py, int width, int height) {
+    // Le point sous (px, py) est à (px - width / 2) / zoom du centre, avant comme après
+    double keep = 1.0 - 1.0 / factor;
+    view_move(view, (px - width / 2) * keep, (py - height / 2) * keep);
+
+    view->zoom = fe_mul_d(view->zoom, factor);
+    #ifdef __linux__
+        fit_precision(view);
+    #endif
+}
+
+void view_offset_pixels(const FractalView *from, const FractalView *to, double *dx, double *dy) {
+    #ifdef __linux__
+        mpfr_t d;
+        mpfr_init2(d, largest(mpfr_get_prec(from->x), mpfr_get_prec(to->x)));
+
+        mpfr_sub(d, to->x, from->x, MPFR_RNDN);
+        *dx = fe_to_double(fe_mul(fe_from_mpfr(d), from->zoom));
+        mpfr_sub(d, to->y, from->y, MPFR_RNDN);
+        *dy = fe_to_double(fe_mul(fe_from_mpfr(d), from->zoom));
+
+        mpfr_clear(d);
+    #else
+        *dx = fe_to_double(fe_mul_d(from->zoom, to->x - from->x));
+        *dy = fe_to_double(fe_mul_d(from->zoom, to->y - from->y));
+    #endif
+}
+
+#ifdef __linux__
+    void view_set_center(FractalView *view, mpfr_srcptr x, mpfr_srcptr y) {
+        mpfr_set_prec(view->x, largest(mpfr_get_prec(x), view_precision(view->zoom)));
+        mpfr_set_prec(view->y, largest(mpfr_get_prec(y), view_precision(view->zoom)));
+        mpfr_set(view->x, x, MPFR_RNDN);
+        mpfr_set(view->y, y, MPFR_RNDN);
+    }
+#endif
+
+double view_center_x(const FractalView *view) {
+    #ifdef __linux__
+        return mpfr_get_d(view->x, MPFR_RNDN);
+    #else
+        return view->x;
+    #endif
+}
+
+double view_center_y(const FractalView *view) {
+    #ifdef __linux__
+        return mpfr_get_d(view->y, MPFR_RNDN);
+    #else
+        return view->y;
+    #endif
+}
+
+bool view_set_zoom_text(FractalView *view, const char *text) {
+    floatexp zoom;
+    #ifdef __linux__
+        mpfr_t parsed;
+        mpfr_init2(parsed, 64);
+        char *end;
+        mpfr_strtofr(parsed, text, &end, 10, MPFR_RNDN);
+        bool valid = *end == '\0' && mpfr_number_p(parsed) && mpfr_sgn(parsed) > 0;
+        zoom = fe_from_mpfr(parsed);
+        mpfr_clear(parsed);
+    #else
+        char *end;
+        double value = strtod(text, &end);
+        bool valid = *end == '\0' && value > 0.0 && value <= DBL_MAX;
+        zoom = fe_from_double(value);
+    #endif
+
+    if (!valid)
+        return false;
+
+    view->zoom = zoom;
+    #ifdef __linux__
+        fit_precision(view);
+    #endif
+    return true;
+}
+
+bool view_set_center_x_text(FractalView *view, const char *text) {
+    #ifdef __linux__
+        return parse_center(view->x, text, view->zoom);
+    #else
+        char *end;
+        double value = strtod(text, &end);
+        if (*end != '\0')
+            return false;
+        view->x = value;
+        return true;
+    #endif
+}
+
+bool view_set_center_y_text(FractalView *view, const char *text) {
+    #ifdef __linux__
+        return parse_center(view->y, text, view->zoom);
+    #else
+        char *end;
+        double value = strtod(text, &end);
+        if (*end != '\0')
+            return false;
+        view->y = value;
+        return true;
+    #endif
+}
+
+void view_format_center(const FractalView *view, char *buffer, size_t size) {
+    // Assez de décimales pour distinguer deux pixels, au moins 6 comme avant
+    // et au plus VIEW_FORMAT_MAX_DIGITS pour que la ligne tienne à l'écran
+    int digits = largest(6, (int)(view->zoom.exponent * 0.30103) + 4);
+    digits = smallest(digits, VIEW_FORMAT_MAX_DIGITS);
+
+    #ifdef __linux__
+        mpfr_snprintf(buffer, size, "X: %.*Rf   Y: %.*Rf", digits, view->x, digits, view->y);
+    #else
+        digits = smallest(digits, 17);
+        snprintf(buffer, size, "X: %.*f   Y: %.*f", digits, view->x, digits, view->y);
+    #endif
+}
+
+void view_apply(const FractalView *view, FractalTask *task) {
+    task->zoom = fmin(fe_to_double(view->zoom), DBL_MAX);
+    task->pixelSize = fe_div(fe_from_double(1.0), view->zoom);
+    task->offsetX = view_center_x(view);
+    task->offsetY = view_center_y(view);
+
+    #ifdef __linux__
+        mpfr_t low;
+        mpfr_init2(low, mpfr_get_prec(view->x));
+        mpfr_sub_d(low, view->x, task->offsetX, MPFR_RNDN);
+        task->offsetXLow = mpfr_get_d(low, MPFR_RNDN);
+        mpfr_set_prec(low, mpfr_get_prec(view->y));
+        mpfr_sub_d(low, view->y, task->offsetY, MPFR_RNDN);
+        task->offsetYLow = mpfr_get_d(low, MPFR_RNDN);
+        mpfr_clear(low);
+
+        mpfr_set_prec(task->centerX, mpfr_get_prec(view->x));
+        mpfr_set_prec(task->centerY, mpfr_get_prec(view->y));
+        mpfr_set(task->centerX, view->x, MPFR_RNDN);
+        mpfr_set(task->centerY, view->y, MPFR_RNDN);
+    #else
+        task->offsetXLow = 0.0;
+        task->offsetYLow = 0.0;
+    #endif
+}